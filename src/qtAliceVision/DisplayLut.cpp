@@ -0,0 +1,119 @@
+#include "DisplayLut.hpp"
+
+#include <QFile>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QTextStream>
+#include <QtDebug>
+
+#include <vector>
+
+namespace qtAliceVision {
+
+namespace {
+
+/// Largest LUT size: tables are packed in a (size * size) x size texture, which must fit GPUs limited to 4096 px textures.
+constexpr int maxLutSize = 64;
+
+/// Parse three floats from the fields of a line, starting at the given field.
+bool parseVector(const QStringList& fields, int first, QVector3D& v)
+{
+    if (fields.size() < first + 3)
+    {
+        return false;
+    }
+    bool ok[3];
+    v = QVector3D(fields[first].toFloat(&ok[0]), fields[first + 1].toFloat(&ok[1]), fields[first + 2].toFloat(&ok[2]));
+    return ok[0] && ok[1] && ok[2];
+}
+
+}  // namespace
+
+std::shared_ptr<DisplayLut> DisplayLut::load(const QString& filepath)
+{
+    QFile file(filepath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        qWarning() << "[QtAliceVision] Failed to open LUT file:" << filepath;
+        return nullptr;
+    }
+
+    auto lut = std::make_shared<DisplayLut>();
+    std::vector<QVector3D> entries;
+
+    QTextStream stream(&file);
+    while (!stream.atEnd())
+    {
+        const QString line = stream.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#'))
+        {
+            continue;
+        }
+
+        const QStringList fields = line.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+        const QString& keyword = fields[0];
+        if (keyword == "TITLE")
+        {
+            continue;
+        }
+        else if (keyword == "LUT_3D_SIZE")
+        {
+            lut->size = (fields.size() > 1) ? fields[1].toInt() : 0;
+            if (lut->size < 2 || lut->size > maxLutSize)
+            {
+                qWarning() << "[QtAliceVision] Invalid LUT size in file:" << filepath << ", max size:" << maxLutSize;
+                return nullptr;
+            }
+            const std::size_t size = static_cast<std::size_t>(lut->size);
+            entries.reserve(size * size * size);
+        }
+        else if (keyword == "DOMAIN_MIN")
+        {
+            parseVector(fields, 1, lut->domainMin);
+        }
+        else if (keyword == "DOMAIN_MAX")
+        {
+            parseVector(fields, 1, lut->domainMax);
+        }
+        else if (keyword == "LUT_3D_INPUT_RANGE" && fields.size() > 2)
+        {
+            const float rangeMin = fields[1].toFloat();
+            const float rangeMax = fields[2].toFloat();
+            lut->domainMin = QVector3D(rangeMin, rangeMin, rangeMin);
+            lut->domainMax = QVector3D(rangeMax, rangeMax, rangeMax);
+        }
+        else
+        {
+            // Table entry, or unsupported keyword (e.g. 1D tables)
+            QVector3D entry;
+            if (!parseVector(fields, 0, entry))
+            {
+                qWarning() << "[QtAliceVision] Unsupported LUT file:" << filepath << "(" << line << ")";
+                return nullptr;
+            }
+            entries.push_back(entry);
+        }
+    }
+
+    const std::size_t size = static_cast<std::size_t>(lut->size);
+    if (size == 0 || entries.size() != size * size * size)
+    {
+        qWarning() << "[QtAliceVision] Incomplete 3D LUT in file:" << filepath;
+        return nullptr;
+    }
+
+    // Entries are listed with red varying fastest, then green, then blue
+    lut->image = std::make_shared<FloatImage>(lut->size * lut->size, lut->size);
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        const int r = static_cast<int>(i % size);
+        const int g = static_cast<int>((i / size) % size);
+        const int b = static_cast<int>(i / (size * size));
+        const QVector3D& entry = entries[i];
+        (*lut->image)(g, r + b * lut->size) = aliceVision::image::RGBAfColor(entry.x(), entry.y(), entry.z(), 1.f);
+    }
+
+    return lut;
+}
+
+}  // namespace qtAliceVision
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "FloatTexture.hpp"
+
+#include <QString>
+#include <QVector3D>
+
+#include <memory>
+
+namespace qtAliceVision {
+
+/**
+ * @brief 3D lookup table applying a display transform on the GPU.
+ *
+ * The table is packed in a 2D image for upload as a regular texture, one blue slice after another:
+ * the entry (r, g, b) is stored at pixel (r + b * size, g) of a (size * size) x size image.
+ * View transforms of color management systems can be baked in this format,
+ * e.g. with `ociobakelut --format resolve_cube` for OpenColorIO.
+ */
+struct DisplayLut
+{
+    /// Number of entries along each axis.
+    int size = 0;
+
+    /// Input values mapped to the first and last entries, on each axis.
+    QVector3D domainMin = QVector3D(0.f, 0.f, 0.f);
+    QVector3D domainMax = QVector3D(1.f, 1.f, 1.f);
+
+    /// Packed table.
+    std::shared_ptr<FloatImage> image;
+
+    /**
+     * @brief Load a 3D lookup table from a file in the Resolve/Adobe .cube format.
+     * @param[in] filepath .cube filepath
+     * @return the lookup table, or null if the file cannot be read or does not contain a valid 3D table
+     */
+    static std::shared_ptr<DisplayLut> load(const QString& filepath);
+};
+
+}  // namespace qtAliceVision
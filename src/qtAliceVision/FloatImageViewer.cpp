@@ -1,19 +1,60 @@
 #include "FloatImageViewer.hpp"
 #include "FloatTexture.hpp"
+#include "IOScheduler.hpp"
 
 #include <QSGFlatColorMaterial>
 #include <QSGGeometry>
 #include <QSGSimpleMaterialShader>
+#include <QQuickWindow>
 #include <QSGTexture>
-#include <QThreadPool>
+#include <QtDebug>
 
 #include <cmath>
 #include <algorithm>
+#include <map>
 #include <vector>
 #include <utility>
 
 namespace qtAliceVision {
 
+namespace {
+
+/// Maximum dimension of the overview displayed under tiles in tiled mode.
+constexpr int tiledOverviewSize = 2048;
+
+/// Maximum number of tiles displayed at once in tiled mode.
+constexpr std::size_t maxDisplayedTiles = 64;
+
+/**
+ * @brief Scene graph node displaying a tile of the image in tiled mode.
+ */
+class TileNode : public QSGGeometryNode
+{
+  public:
+    TileNode(const imgserve::TileKey& tileKey, const std::shared_ptr<FloatImage>& tileImage)
+      : key(tileKey),
+        image(tileImage)
+    {
+        auto geometry = new QSGGeometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), 4);
+        setGeometry(geometry);
+        setFlag(QSGNode::OwnsGeometry);
+
+        auto texture = std::make_unique<FloatTexture>();
+        texture->setImage(image);
+        texture->setFiltering(QSGTexture::Nearest);
+
+        auto material = ImageViewerShader::createMaterial();
+        material->state()->texture = std::move(texture);
+        setMaterial(material);
+        setFlag(QSGNode::OwnsMaterial);
+    }
+
+    imgserve::TileKey key;
+    std::shared_ptr<FloatImage> image;
+};
+
+}  // namespace
+
 FloatImageViewer::FloatImageViewer(QQuickItem* parent)
   : QQuickItem(parent)
 {
@@ -22,6 +63,9 @@ FloatImageViewer::FloatImageViewer(QQuickItem* parent)
     // CONNECTS
     connect(this, &FloatImageViewer::gammaChanged, this, &FloatImageViewer::update);
     connect(this, &FloatImageViewer::gainChanged, this, &FloatImageViewer::update);
+    connect(this, &FloatImageViewer::exposureChanged, this, &FloatImageViewer::update);
+    connect(this, &FloatImageViewer::displayModeChanged, this, &FloatImageViewer::update);
+    connect(this, &FloatImageViewer::zebraThresholdChanged, this, &FloatImageViewer::update);
 
     connect(this, &FloatImageViewer::textureSizeChanged, this, &FloatImageViewer::update);
     connect(this, &FloatImageViewer::sourceSizeChanged, this, &FloatImageViewer::update);
@@ -45,7 +89,22 @@ FloatImageViewer::FloatImageViewer(QQuickItem* parent)
     connect(&_singleImageLoader, &imgserve::SingleImageLoader::requestHandled, this, &FloatImageViewer::reload);
     connect(&_sequenceCache, &imgserve::SequenceCache::requestHandled, this, &FloatImageViewer::reload);
     connect(&_sequenceCache, &imgserve::SequenceCache::contentChanged, this, &FloatImageViewer::reload);
+    connect(&_sequenceCache, &imgserve::SequenceCache::cacheCapacityChanged, this, &FloatImageViewer::onCacheCapacityChanged);
     connect(this, &FloatImageViewer::useSequenceChanged, this, &FloatImageViewer::reload);
+
+    connect(this, &FloatImageViewer::viewportChanged, this, &FloatImageViewer::updateTiles);
+    connect(this, &FloatImageViewer::widthChanged, this, &FloatImageViewer::updateTiles);
+    connect(this, &FloatImageViewer::heightChanged, this, &FloatImageViewer::updateTiles);
+    connect(&_tileCache, &imgserve::TileCache::tileLoaded, this, &FloatImageViewer::updateTiles);
+
+    connect(this, &FloatImageViewer::imageChanged, this, &FloatImageViewer::updateScopes);
+    connect(this, &FloatImageViewer::gammaChanged, this, &FloatImageViewer::updateScopes);
+    connect(this, &FloatImageViewer::gainChanged, this, &FloatImageViewer::updateScopes);
+    connect(this, &FloatImageViewer::exposureChanged, this, &FloatImageViewer::updateScopes);
+
+    connect(&_playbackClock, &PlaybackClock::frameDue, this, &FloatImageViewer::onFrameDue);
+    connect(&_playbackClock, &PlaybackClock::statsChanged, this, &FloatImageViewer::onPlaybackStatsChanged);
+    connect(this, &FloatImageViewer::sequenceChanged, this, &FloatImageViewer::updatePlaybackRange);
 }
 
 FloatImageViewer::~FloatImageViewer() {}
@@ -64,7 +123,9 @@ void FloatImageViewer::setLoading(bool loading)
 void FloatImageViewer::setSequence(const QVariantList& paths)
 {
     _sequenceCache.setSequence(paths);
+    _pinnedFrames.clear();
     Q_EMIT sequenceChanged();
+    Q_EMIT pinnedFramesChanged();
 }
 
 void FloatImageViewer::setTargetSize(int size)
@@ -73,6 +134,182 @@ void FloatImageViewer::setTargetSize(int size)
     Q_EMIT targetSizeChanged();
 }
 
+void FloatImageViewer::setPrefetchThreads(int nbThreads)
+{
+    if (nbThreads == _sequenceCache.getPrefetchingThreads())
+        return;
+
+    _sequenceCache.setPrefetchingThreads(nbThreads);
+    Q_EMIT prefetchThreadsChanged();
+}
+
+double FloatImageViewer::getCacheBudget() const
+{
+    const double factorConvertMiB = 1024. * 1024.;
+    return static_cast<double>(_sequenceCache.getCacheCapacity()) / factorConvertMiB;
+}
+
+void FloatImageViewer::setCacheBudget(double budget)
+{
+    const double factorConvertMiB = 1024. * 1024.;
+    const uint64_t capacity = static_cast<uint64_t>(std::max(0., budget) * factorConvertMiB);
+    if (capacity == _sequenceCache.getCacheCapacity())
+        return;
+
+    // Notifications are emitted by the shared cache, for all viewers
+    _sequenceCache.setCacheCapacity(capacity);
+}
+
+void FloatImageViewer::setCacheRamRatio(double ratio)
+{
+    if (std::clamp(ratio, 0., 1.) == getCacheRamRatio())
+        return;
+
+    _sequenceCache.setCacheCapacityRatio(ratio);
+}
+
+void FloatImageViewer::onCacheCapacityChanged()
+{
+    Q_EMIT cacheBudgetChanged();
+    Q_EMIT cacheRamRatioChanged();
+    Q_EMIT cachedFramesChanged();
+}
+
+void FloatImageViewer::setEvictionPolicy(EEvictionPolicy policy)
+{
+    if (policy == getEvictionPolicy())
+        return;
+
+    _sequenceCache.setEvictionPolicy(static_cast<imgserve::EEvictionPolicy>(policy));
+    Q_EMIT evictionPolicyChanged();
+}
+
+void FloatImageViewer::setPinnedFrames(const QVariantList& frames)
+{
+    _pinnedFrames = frames;
+    _sequenceCache.setPinnedFrames(frames);
+    Q_EMIT pinnedFramesChanged();
+}
+
+void FloatImageViewer::setHalfFloat(bool halfFloat)
+{
+    if (halfFloat == getHalfFloat())
+        return;
+
+    const imgserve::EStorageMode mode = halfFloat ? imgserve::EStorageMode::Half : imgserve::EStorageMode::Float;
+    _sequenceCache.setStorageMode(mode);
+    _singleImageLoader.setStorageMode(mode);
+    Q_EMIT halfFloatChanged();
+}
+
+void FloatImageViewer::setProgressive(bool progressive)
+{
+    if (progressive == getProgressive())
+        return;
+
+    _sequenceCache.setProgressive(progressive);
+    Q_EMIT progressiveChanged();
+    reload();
+}
+
+void FloatImageViewer::setPersistentCache(bool persistent)
+{
+    if (persistent == getPersistentCache())
+        return;
+
+    _sequenceCache.setPersistentCache(persistent);
+    Q_EMIT persistentCacheChanged();
+}
+
+void FloatImageViewer::setTiled(bool tiled)
+{
+    if (tiled == _tiled)
+        return;
+
+    _tiled = tiled;
+    if (!_tiled)
+    {
+        // Release tiles
+        _tileCache.setSource(std::string());
+    }
+    Q_EMIT tiledChanged();
+    reload();
+}
+
+void FloatImageViewer::setDisplayLut(const QUrl& source)
+{
+    if (source == _displayLutSource)
+        return;
+
+    // The table is uploaded once, images are not reloaded
+    _displayLutSource = source;
+    _displayLut = source.isEmpty() ? nullptr : DisplayLut::load(source.toLocalFile());
+    _displayLutChanged = true;
+    Q_EMIT displayLutChanged();
+    update();
+}
+
+void FloatImageViewer::setScopesEnabled(bool enabled)
+{
+    if (enabled == _scopesEnabled)
+        return;
+
+    _scopesEnabled = enabled;
+    Q_EMIT scopesEnabledChanged();
+    updateScopes();
+}
+
+void FloatImageViewer::updateScopes()
+{
+    if (!_scopesEnabled || !hasImage())
+    {
+        return;
+    }
+
+    // A single computation at a time: during playback, frames displayed meanwhile are skipped
+    if (_scopesRunning)
+    {
+        _scopesOutdated = true;
+        return;
+    }
+
+    _scopesRunning = true;
+    _scopesOutdated = false;
+    auto runnable = new ScopesRunnable(_image, _halfImage, _gain * std::exp2(_exposure), _gamma);
+    connect(runnable, &ScopesRunnable::done, this, &FloatImageViewer::onScopesComputed);
+    IOScheduler::instance().start(IOScheduler::EIOClass::Analysis, runnable);
+}
+
+void FloatImageViewer::onScopesComputed(ImageScopes scopes)
+{
+    _scopesRunning = false;
+
+    _scopes = std::move(scopes);
+    _histograms.clear();
+    for (const std::vector<float>& histogram : _scopes.histograms)
+    {
+        QVariantList bins;
+        bins.reserve(static_cast<int>(histogram.size()));
+        for (const float value : histogram)
+        {
+            bins.append(value);
+        }
+        _histograms.append(QVariant(bins));
+    }
+    _waveform.clear();
+    _waveform.reserve(static_cast<int>(_scopes.waveform.size()));
+    for (const float value : _scopes.waveform)
+    {
+        _waveform.append(value);
+    }
+    Q_EMIT scopesChanged();
+
+    if (_scopesOutdated)
+    {
+        updateScopes();
+    }
+}
+
 QVariantList FloatImageViewer::getCachedFrames() const { return _sequenceCache.getCachedFrames(); }
 
 void FloatImageViewer::reload()
@@ -80,6 +317,7 @@ void FloatImageViewer::reload()
     if (_clearBeforeLoad)
     {
         _image.reset();
+        _halfImage.reset();
         _imageChanged = true;
         Q_EMIT imageChanged();
     }
@@ -91,6 +329,7 @@ void FloatImageViewer::reload()
     if (!_source.isValid())
     {
         _image.reset();
+        _halfImage.reset();
         _imageChanged = true;
         _surface.clearVertices();
         _surface.verticesChanged();
@@ -102,24 +341,52 @@ void FloatImageViewer::reload()
     imgserve::RequestData reqData;
     reqData.path = _source.toLocalFile().toUtf8().toStdString();
     reqData.downscale = 1 << _downscaleLevel;
+    reqData.maxSize = std::max(0, FloatTexture::maxTextureSize());
+
+    // In tiled mode, a low resolution overview is displayed under tiles
+    // Images that cannot be read by region are displayed entirely
+    if (_tiled && !_useSequence)
+    {
+        _tileCache.setSource(reqData.path);
+        if (_tileCache.isTileable())
+        {
+            reqData.maxSize = (reqData.maxSize > 0) ? std::min(reqData.maxSize, tiledOverviewSize) : tiledOverviewSize;
+        }
+    }
 
     imgserve::ResponseData response = _useSequence ? _sequenceCache.request(reqData) : _singleImageLoader.request(reqData);
 
-    if (response.img)
+    if (response.img || response.halfImg)
     {
-        setLoading(false);
+        // Keep loading state while displaying a proxy, until the requested image is available
+        setLoading(response.proxy);
+
+        if (_proxy != response.proxy)
+        {
+            _proxy = response.proxy;
+            Q_EMIT proxyChanged();
+        }
 
         _surface.setVerticesChanged(true);
         _surface.setNeedToUseIntrinsic(true);
         _image = response.img;
+        _halfImage = response.halfImg;
         _imageChanged = true;
         Q_EMIT imageChanged();
 
+        // Texture upload copies the whole image once more, from client memory to the driver
+        const uint64_t bytesPerPixel = _halfImage ? 4 * sizeof(uint16_t) : sizeof(aliceVision::image::RGBAfColor);
+        const uint64_t uploadBytes = static_cast<uint64_t>(imageSize().width()) * static_cast<uint64_t>(imageSize().height()) * bytesPerPixel;
+        _frameBytesCopied = static_cast<qint64>(response.bytesCopied + uploadBytes);
+        Q_EMIT frameBytesCopiedChanged();
+
         _sourceSize = response.dim;
         Q_EMIT sourceSizeChanged();
 
         _metadata = response.metadata;
         Q_EMIT metadataChanged();
+
+        updateTiles();
     }
     else
     {
@@ -133,21 +400,246 @@ void FloatImageViewer::playback(bool active)
 {
     // Turn off interactive prefetching when playback is ON
     _sequenceCache.setInteractivePrefetching(!active);
+
+    // Favor upcoming frames during playback, frames on both sides when scrubbing
+    if (active)
+    {
+        _sequenceCache.setPrefetchPolicy(std::make_unique<imgserve::DirectionalPrefetchPolicy>());
+    }
+    else
+    {
+        _sequenceCache.setPrefetchPolicy(std::make_unique<imgserve::SymmetricPrefetchPolicy>());
+    }
+}
+
+void FloatImageViewer::setFps(double fps)
+{
+    if (fps == getFps())
+        return;
+
+    _playbackClock.setFps(fps);
+    Q_EMIT fpsChanged();
+}
+
+void FloatImageViewer::setLoopIn(int frame)
+{
+    if (frame == _loopIn)
+        return;
+
+    _loopIn = frame;
+    updatePlaybackRange();
+    Q_EMIT loopChanged();
+}
+
+void FloatImageViewer::setLoopOut(int frame)
+{
+    if (frame == _loopOut)
+        return;
+
+    _loopOut = frame;
+    updatePlaybackRange();
+    Q_EMIT loopChanged();
+}
+
+void FloatImageViewer::updatePlaybackRange()
+{
+    const int lastFrame = _sequenceCache.getNbFrames() - 1;
+    if (lastFrame < 0)
+    {
+        setPlaying(false);
+        return;
+    }
+
+    const int first = std::clamp(_loopIn, 0, lastFrame);
+    const int last = (_loopOut < 0) ? lastFrame : std::clamp(_loopOut, first, lastFrame);
+    _playbackClock.setRange(first, last);
+}
+
+void FloatImageViewer::setPlaying(bool playing)
+{
+    if (playing == isPlaying())
+        return;
+
+    if (playing)
+    {
+        if (!_useSequence || _sequenceCache.getNbFrames() == 0)
+            return;
+
+        // Statistics cover a single playback session
+        _sequenceCache.clearDecodeLatencies();
+        playback(true);
+        updatePlaybackRange();
+
+        // Start from the displayed frame
+        const int frame = _sequenceCache.getFrame(_source.toLocalFile().toUtf8().toStdString());
+        _playbackClock.start(frame);
+    }
+    else
+    {
+        _playbackClock.stop();
+        playback(false);
+    }
+    Q_EMIT playingChanged();
+}
+
+void FloatImageViewer::onFrameDue(int frame)
+{
+    const std::string path = _sequenceCache.getFramePath(frame);
+
+    if (!_sequenceCache.isCached(frame))
+    {
+        // Keep displaying the previous frame, the due frame is dropped
+        _playbackClock.reportFrame(false);
+
+        // Request it anyway, so that prefetching follows the playhead
+        imgserve::RequestData reqData;
+        reqData.path = path;
+        reqData.downscale = 1 << _downscaleLevel;
+        reqData.maxSize = std::max(0, FloatTexture::maxTextureSize());
+        _sequenceCache.request(reqData);
+        return;
+    }
+
+    _playbackClock.reportFrame(true);
+    _currentFrame = frame;
+    Q_EMIT currentFrameChanged();
+
+    // Image is retrieved from cache on reload
+    _source = QUrl::fromLocalFile(QString::fromStdString(path));
+    Q_EMIT sourceChanged();
+}
+
+void FloatImageViewer::onPlaybackStatsChanged()
+{
+    _playbackStats.clear();
+    _playbackStats.insert("deliveredFps", _playbackClock.getDeliveredFps());
+    _playbackStats.insert("hitRatio", _playbackClock.getHitRatio());
+    _playbackStats.insert("deliveredFrames", _playbackClock.getDeliveredFrames());
+    _playbackStats.insert("droppedFrames", _playbackClock.getDroppedFrames());
+    _playbackStats.insert("decodeLatencyP50", _sequenceCache.getDecodeLatency(50.0));
+    _playbackStats.insert("decodeLatencyP90", _sequenceCache.getDecodeLatency(90.0));
+    _playbackStats.insert("decodeLatencyP99", _sequenceCache.getDecodeLatency(99.0));
+    Q_EMIT playbackStatsChanged();
+
+    qInfo().nospace() << "[QtAliceVision] Playback: " << _playbackClock.getDeliveredFps() << "/" << getFps() << " fps, hit ratio "
+                      << _playbackClock.getHitRatio() << ", " << _playbackClock.getDeliveredFrames() << " frames delivered, "
+                      << _playbackClock.getDroppedFrames() << " dropped, decode latency p50/p90/p99 " << _sequenceCache.getDecodeLatency(50.0)
+                      << "/" << _sequenceCache.getDecodeLatency(90.0) << "/" << _sequenceCache.getDecodeLatency(99.0) << " ms";
+}
+
+bool FloatImageViewer::isTiling() const
+{
+    // Tiles are only displayed on undistorted images
+    return _tiled && !_useSequence && _tileCache.isTileable() && hasImage() && !_sourceSize.isEmpty() && !_surface.isPanoramaViewerEnabled() &&
+           !_surface.isDistortionViewerEnabled() && !_cropFisheye;
+}
+
+void FloatImageViewer::updateTiles()
+{
+    std::vector<DisplayedTile> tiles;
+
+    if (isTiling())
+    {
+        // The image covers source pixel coordinates in the item
+        const QRectF imageRect(QPointF(0, 0), QSizeF(_sourceSize));
+
+        // Screen pixels per image pixel
+        const double devicePixelRatio = window() ? window()->effectiveDevicePixelRatio() : 1.0;
+        const double scale = mapRectToScene(imageRect).width() / imageRect.width() * devicePixelRatio;
+
+        // Tiles are only needed where the overview resolution is below screen resolution
+        const int overviewLevel =
+          static_cast<int>(std::round(std::log2(static_cast<double>(_sourceSize.width()) / static_cast<double>(imageSize().width()))));
+        const int level = (scale > 0.0) ? std::max(0, static_cast<int>(std::floor(std::log2(1.0 / scale)))) : overviewLevel;
+
+        QRectF visible = _viewport;
+        if (visible.isEmpty())
+        {
+            visible = window() ? mapRectFromScene(QRectF(0, 0, window()->width(), window()->height())) : imageRect;
+        }
+        visible &= imageRect;
+
+        std::vector<imgserve::TileKey> keys;
+        const int tileSize = imgserve::TileCache::tileSize;
+        const int levelScale = 1 << level;
+        if (level < overviewLevel && !visible.isEmpty())
+        {
+            // Tiles intersecting the visible area, at the level resolution
+            const double tileExtent = static_cast<double>(tileSize * levelScale);
+            const int xBegin = static_cast<int>(std::floor(visible.left() / tileExtent));
+            const int yBegin = static_cast<int>(std::floor(visible.top() / tileExtent));
+            const int xEnd = static_cast<int>(std::ceil(visible.right() / tileExtent));
+            const int yEnd = static_cast<int>(std::ceil(visible.bottom() / tileExtent));
+            for (int y = yBegin; y < yEnd; ++y)
+            {
+                for (int x = xBegin; x < xEnd; ++x)
+                {
+                    keys.push_back({level, x, y});
+                }
+            }
+
+            // Load tiles from the center of the viewport outwards
+            const QPointF center = visible.center() / tileExtent;
+            auto distance = [&center](const imgserve::TileKey& key) {
+                return std::hypot(key.x + 0.5 - center.x(), key.y + 0.5 - center.y());
+            };
+            std::sort(keys.begin(), keys.end(), [&distance](const imgserve::TileKey& a, const imgserve::TileKey& b) {
+                return distance(a) < distance(b);
+            });
+            keys.resize(std::min(keys.size(), maxDisplayedTiles));
+        }
+
+        // Request tiles, even if there are none to drop tiles queued for a previous viewport
+        const std::vector<std::shared_ptr<FloatImage>> images = _tileCache.request(keys);
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            if (!images[i])
+            {
+                continue;
+            }
+            const QRectF rect(keys[i].x * tileSize * levelScale,
+                              keys[i].y * tileSize * levelScale,
+                              images[i]->Width() * levelScale,
+                              images[i]->Height() * levelScale);
+            tiles.push_back({keys[i], images[i], rect & imageRect});
+        }
+    }
+
+    if (tiles.empty() && _tiles.empty())
+    {
+        return;
+    }
+
+    _tiles = std::move(tiles);
+    update();
+}
+
+QSize FloatImageViewer::imageSize() const
+{
+    if (_halfImage)
+    {
+        return QSize(_halfImage->Width(), _halfImage->Height());
+    }
+    if (_image)
+    {
+        return QSize(_image->Width(), _image->Height());
+    }
+    return QSize();
 }
 
 QVector4D FloatImageViewer::pixelValueAt(int x, int y)
 {
-    if (!_image)
+    if (!hasImage())
     {
         // qInfo() << "[QtAliceVision] FloatImageViewer::pixelValueAt(" << x << ", " << y << ") => no valid image";
         return QVector4D(0.0, 0.0, 0.0, 0.0);
     }
-    else if (x < 0 || x >= _image->Width() || y < 0 || y >= _image->Height())
+    else if (x < 0 || x >= imageSize().width() || y < 0 || y >= imageSize().height())
     {
         // qInfo() << "[QtAliceVision] FloatImageViewer::pixelValueAt(" << x << ", " << y << ") => out of range";
         return QVector4D(0.0, 0.0, 0.0, 0.0);
     }
-    aliceVision::image::RGBAfColor color = (*_image)(y, x);
+    aliceVision::image::RGBAfColor color = _halfImage ? (*_halfImage)(y, x) : (*_image)(y, x);
     // qInfo() << "[QtAliceVision] FloatImageViewer::pixelValueAt(" << x << ", " << y << ") => valid pixel: " <<
     // color(0) << ", " << color(1) << ", " << color(2) << ", " << color(3);
     return QVector4D(color(0), color(1), color(2), color(3));
@@ -194,6 +686,9 @@ QSGNode* FloatImageViewer::updatePaintNode(QSGNode* oldNode, QQuickItem::UpdateP
             }
             root->appendChildNode(node);
         }
+
+        // Parent node of tiles, displayed over the image
+        root->appendChildNode(new QSGNode);
     }
     else
     {
@@ -251,14 +746,60 @@ QSGNode* FloatImageViewer::updatePaintNode(QSGNode* oldNode, QQuickItem::UpdateP
     material->state()->gamma = _gamma;
     material->state()->gain = _gain;
     material->state()->channelOrder = channelOrder;
+    material->state()->exposure = _exposure;
+    material->state()->displayMode = static_cast<float>(_displayMode);
+    material->state()->zebraThreshold = _zebraThreshold;
+
+    if (_displayLutChanged || (_displayLut && !material->state()->lut))
+    {
+        if (_displayLut)
+        {
+            auto lut = std::make_shared<FloatTexture>();
+            lut->setImage(_displayLut->image);
+            lut->setFiltering(QSGTexture::Linear);
+            lut->setHorizontalWrapMode(QSGTexture::ClampToEdge);
+            lut->setVerticalWrapMode(QSGTexture::ClampToEdge);
+            material->state()->lut = lut;
+            material->state()->lutSize = static_cast<float>(_displayLut->size);
+            material->state()->lutDomainMin = _displayLut->domainMin;
+            material->state()->lutDomainMax = _displayLut->domainMax;
+        }
+        else
+        {
+            material->state()->lut.reset();
+        }
+        _displayLutChanged = false;
+    }
 
     if (_imageChanged)
     {
         QSize newTextureSize;
-        auto texture = std::make_unique<FloatTexture>();
-        if (_image)
+        if (hasImage())
         {
-            texture->setImage(_image);
+            // Images exceeding the max texture size are not displayed: reload them now that the max size is known,
+            // so that they are downscaled when loaded instead of on the render thread
+            FloatTexture::queryMaxTextureSize();
+            if (!FloatTexture::fitsMaxTextureSize(imageSize()))
+            {
+                QMetaObject::invokeMethod(this, &FloatImageViewer::reload, Qt::QueuedConnection);
+            }
+
+            // Reuse the current texture across frames: its storage and pixel buffers are recycled
+            auto* texture = dynamic_cast<FloatTexture*>(material->state()->texture.get());
+            if (!texture)
+            {
+                material->state()->texture = std::make_unique<FloatTexture>();
+                texture = static_cast<FloatTexture*>(material->state()->texture.get());
+            }
+            if (_halfImage)
+            {
+                texture->setImage(_halfImage);
+            }
+            else
+            {
+                texture->setImage(_image);
+            }
+            texture->setWindow(window());
             texture->setFiltering(QSGTexture::Nearest);
             texture->setHorizontalWrapMode(QSGTexture::Repeat);
             texture->setVerticalWrapMode(QSGTexture::Repeat);
@@ -271,8 +812,9 @@ QSGNode* FloatImageViewer::updatePaintNode(QSGNode* oldNode, QQuickItem::UpdateP
                 const aliceVision::Vec3 fisheyeCircleParams(
                   intrinsicEquidistant->getCircleCenterX(), intrinsicEquidistant->getCircleCenterY(), intrinsicEquidistant->getCircleRadius());
 
-                const double width = _image->Width() * pow(2.0, _downscaleLevel);
-                const double height = _image->Height() * pow(2.0, _downscaleLevel);
+                // Proxies are smaller than the requested image: use source dimensions instead
+                const double width = _proxy ? _sourceSize.width() : imageSize().width() * pow(2.0, _downscaleLevel);
+                const double height = _proxy ? _sourceSize.height() : imageSize().height() * pow(2.0, _downscaleLevel);
                 const double aspectRatio = (width > height) ? width / height : height / width;
 
                 const double radiusInPercentage = (fisheyeCircleParams.z() / ((width > height) ? height : width)) * 2.0;
@@ -290,7 +832,10 @@ QSGNode* FloatImageViewer::updatePaintNode(QSGNode* oldNode, QQuickItem::UpdateP
                 material->state()->fisheyeCircleRadius = 0.0;
             }
         }
-        material->state()->texture = std::move(texture);
+        else
+        {
+            material->state()->texture = std::make_unique<FloatTexture>();
+        }
 
         _imageChanged = false;
 
@@ -330,11 +875,13 @@ QSGNode* FloatImageViewer::updatePaintNode(QSGNode* oldNode, QQuickItem::UpdateP
     /*
      * Surface
      */
-    if (root && !_createRoot && _image)
+    if (root && !_createRoot && hasImage())
     {
         updatePaintSurface(root, material, geometryLine);
     }
 
+    updatePaintTiles(root->childAtIndex(1), material);
+
     return root;
 }
 
@@ -375,4 +922,58 @@ void FloatImageViewer::updatePaintSurface(QSGGeometryNode* root, QSGSimpleMateri
     root->childAtIndex(0)->markDirty(QSGNode::DirtyGeometry | QSGNode::DirtyMaterial);
 }
 
+void FloatImageViewer::updatePaintTiles(QSGNode* tileRoot, const QSGSimpleMaterial<ShaderData>* imageMaterial)
+{
+    const ShaderData& state = *(imageMaterial->state());
+
+    // Retrieve current tile nodes
+    std::map<imgserve::TileKey, TileNode*> nodes;
+    for (QSGNode* child = tileRoot->firstChild(); child; child = child->nextSibling())
+    {
+        auto node = static_cast<TileNode*>(child);
+        nodes[node->key] = node;
+    }
+
+    for (const DisplayedTile& tile : _tiles)
+    {
+        // Reuse the node of a tile that is still displayed: its texture is already uploaded
+        TileNode* node = nullptr;
+        const auto it = nodes.find(tile.key);
+        if (it != nodes.end() && it->second->image == tile.image)
+        {
+            node = it->second;
+            nodes.erase(it);
+        }
+        else
+        {
+            node = new TileNode(tile.key, tile.image);
+            tileRoot->appendChildNode(node);
+        }
+
+        QSGGeometry::updateTexturedRectGeometry(node->geometry(), tile.rect, QRectF(0, 0, 1, 1));
+
+        // Tiles are displayed with the same parameters as the image
+        auto material = static_cast<QSGSimpleMaterial<ShaderData>*>(node->material());
+        material->state()->gamma = state.gamma;
+        material->state()->gain = state.gain;
+        material->state()->channelOrder = state.channelOrder;
+        material->state()->exposure = state.exposure;
+        material->state()->displayMode = state.displayMode;
+        material->state()->zebraThreshold = state.zebraThreshold;
+        material->state()->lut = state.lut;
+        material->state()->lutSize = state.lutSize;
+        material->state()->lutDomainMin = state.lutDomainMin;
+        material->state()->lutDomainMax = state.lutDomainMax;
+        material->setFlag(QSGMaterial::Blending, imageMaterial->flags() & QSGMaterial::Blending);
+        node->markDirty(QSGNode::DirtyGeometry | QSGNode::DirtyMaterial);
+    }
+
+    // Remove nodes of tiles that are not displayed anymore
+    for (const auto& entry : nodes)
+    {
+        tileRoot->removeChildNode(entry.second);
+        delete entry.second;
+    }
+}
+
 }  // namespace qtAliceVision
@@ -1,10 +1,14 @@
 #pragma once
 
+#include "DisplayLut.hpp"
 #include "FloatTexture.hpp"
+#include "ImageScopes.hpp"
+#include "PlaybackClock.hpp"
 #include "Surface.hpp"
 #include "ShaderImageViewer.hpp"
 #include "SequenceCache.hpp"
 #include "SingleImageLoader.hpp"
+#include "TileCache.hpp"
 
 #include <aliceVision/image/all.hpp>
 
@@ -19,6 +23,7 @@
 #include <memory>
 #include <string>
 #include <algorithm>
+#include <vector>
 
 namespace qtAliceVision {
 
@@ -63,6 +68,85 @@ class FloatImageViewer : public QQuickItem
 
     Q_PROPERTY(bool useSequence MEMBER _useSequence NOTIFY useSequenceChanged)
 
+    Q_PROPERTY(int prefetchThreads READ getPrefetchThreads WRITE setPrefetchThreads NOTIFY prefetchThreadsChanged)
+
+    /// Memory budget of the image cache shared by all viewers, in MB
+    Q_PROPERTY(double cacheBudget READ getCacheBudget WRITE setCacheBudget NOTIFY cacheBudgetChanged)
+
+    /// Memory budget of the image cache shared by all viewers, as a proportion of available RAM
+    Q_PROPERTY(double cacheRamRatio READ getCacheRamRatio WRITE setCacheRamRatio NOTIFY cacheRamRatioChanged)
+
+    Q_PROPERTY(EEvictionPolicy evictionPolicy READ getEvictionPolicy WRITE setEvictionPolicy NOTIFY evictionPolicyChanged)
+
+    /// Frames kept in cache with the Keyframes eviction policy
+    Q_PROPERTY(QVariantList pinnedFrames READ getPinnedFrames WRITE setPinnedFrames NOTIFY pinnedFramesChanged)
+
+    /// Store loaded images in half float precision, halving memory usage and upload bandwidth
+    Q_PROPERTY(bool halfFloat READ getHalfFloat WRITE setHalfFloat NOTIFY halfFloatChanged)
+
+    /// Display a low resolution proxy while the requested frame of a sequence is loading
+    Q_PROPERTY(bool progressive READ getProgressive WRITE setProgressive NOTIFY progressiveChanged)
+
+    /// The displayed image is a low resolution proxy
+    Q_PROPERTY(bool proxy READ isProxy NOTIFY proxyChanged)
+
+    /// Keep downscaled frames of sequences on disk, to avoid decoding them again in later sessions
+    Q_PROPERTY(bool persistentCache READ getPersistentCache WRITE setPersistentCache NOTIFY persistentCacheChanged)
+
+    /// Bytes copied in memory to display the current frame, from decoded pixels to texture upload
+    Q_PROPERTY(qint64 frameBytesCopied READ getFrameBytesCopied NOTIFY frameBytesCopiedChanged)
+
+    /// Display single images with tiles loaded at the resolution of the viewport, over a low resolution overview
+    /// (only tiled files are read by tiles, other images are displayed entirely)
+    Q_PROPERTY(bool tiled READ getTiled WRITE setTiled NOTIFY tiledChanged)
+
+    /// Region of the item visible on screen in item coordinates, used to select tiles (the whole window if empty)
+    Q_PROPERTY(QRectF viewport MEMBER _viewport NOTIFY viewportChanged)
+
+    /// Exposure adjustment applied before the display transform, in stops
+    Q_PROPERTY(float exposure MEMBER _exposure NOTIFY exposureChanged)
+
+    Q_PROPERTY(EDisplayMode displayMode MEMBER _displayMode NOTIFY displayModeChanged)
+
+    /// Display value above which zebra stripes are drawn
+    Q_PROPERTY(float zebraThreshold MEMBER _zebraThreshold NOTIFY zebraThresholdChanged)
+
+    /// 3D LUT file (.cube) replacing the gamma and sRGB display transform, none if empty
+    Q_PROPERTY(QUrl displayLut READ getDisplayLut WRITE setDisplayLut NOTIFY displayLutChanged)
+
+    /// Compute scopes of the displayed image in a worker thread, each time it or its display parameters change
+    Q_PROPERTY(bool scopesEnabled READ getScopesEnabled WRITE setScopesEnabled NOTIFY scopesEnabledChanged)
+
+    /// Histograms of red, green, blue and luma display values (lists of normalized bins)
+    Q_PROPERTY(QVariantList histograms READ getHistograms NOTIFY scopesChanged)
+
+    /// Luma waveform: normalized densities, row by row from the highest luma value
+    Q_PROPERTY(QVariantList waveform READ getWaveform NOTIFY scopesChanged)
+
+    Q_PROPERTY(QSize waveformSize READ getWaveformSize CONSTANT)
+
+    /// Minimum, maximum and average RGBA values of the image
+    Q_PROPERTY(QVector4D imageMinimum READ getImageMinimum NOTIFY scopesChanged)
+    Q_PROPERTY(QVector4D imageMaximum READ getImageMaximum NOTIFY scopesChanged)
+    Q_PROPERTY(QVector4D imageAverage READ getImageAverage NOTIFY scopesChanged)
+
+    /// Target frame rate of sequence playback
+    Q_PROPERTY(double fps READ getFps WRITE setFps NOTIFY fpsChanged)
+
+    /// First and last frames played in loop (the whole sequence if negative)
+    Q_PROPERTY(int loopIn READ getLoopIn WRITE setLoopIn NOTIFY loopChanged)
+    Q_PROPERTY(int loopOut READ getLoopOut WRITE setLoopOut NOTIFY loopChanged)
+
+    /// Play the sequence at the target frame rate, skipping frames that are not in cache when due
+    Q_PROPERTY(bool playing READ isPlaying WRITE setPlaying NOTIFY playingChanged)
+
+    /// Frame of the sequence displayed during playback
+    Q_PROPERTY(int currentFrame READ getCurrentFrame NOTIFY currentFrameChanged)
+
+    /// Statistics of the current or last playback, updated every second:
+    /// deliveredFps, hitRatio, deliveredFrames, droppedFrames and decodeLatencyP50/P90/P99 (milliseconds)
+    Q_PROPERTY(QVariantMap playbackStats READ getPlaybackStats NOTIFY playbackStatsChanged)
+
   public:
     explicit FloatImageViewer(QQuickItem* parent = nullptr);
     ~FloatImageViewer() override;
@@ -96,6 +180,22 @@ class FloatImageViewer : public QQuickItem
     };
     Q_ENUM(EChannelMode)
 
+    enum class EEvictionPolicy : quint8
+    {
+        LRU,
+        Distance,
+        Keyframes
+    };
+    Q_ENUM(EEvictionPolicy)
+
+    enum class EDisplayMode : quint8
+    {
+        Image,
+        FalseColor,
+        Zebra
+    };
+    Q_ENUM(EDisplayMode)
+
     bool getCropFisheye() const { return _cropFisheye; }
     void setCropFisheye(bool cropFisheye) { _cropFisheye = cropFisheye; }
 
@@ -121,6 +221,29 @@ class FloatImageViewer : public QQuickItem
     Q_SIGNAL void targetSizeChanged();
     Q_SIGNAL void cachedFramesChanged();
     Q_SIGNAL void useSequenceChanged();
+    Q_SIGNAL void prefetchThreadsChanged();
+    Q_SIGNAL void cacheBudgetChanged();
+    Q_SIGNAL void cacheRamRatioChanged();
+    Q_SIGNAL void evictionPolicyChanged();
+    Q_SIGNAL void pinnedFramesChanged();
+    Q_SIGNAL void halfFloatChanged();
+    Q_SIGNAL void progressiveChanged();
+    Q_SIGNAL void proxyChanged();
+    Q_SIGNAL void persistentCacheChanged();
+    Q_SIGNAL void frameBytesCopiedChanged();
+    Q_SIGNAL void tiledChanged();
+    Q_SIGNAL void viewportChanged();
+    Q_SIGNAL void exposureChanged();
+    Q_SIGNAL void displayModeChanged();
+    Q_SIGNAL void zebraThresholdChanged();
+    Q_SIGNAL void displayLutChanged();
+    Q_SIGNAL void scopesEnabledChanged();
+    Q_SIGNAL void scopesChanged();
+    Q_SIGNAL void fpsChanged();
+    Q_SIGNAL void loopChanged();
+    Q_SIGNAL void playingChanged();
+    Q_SIGNAL void currentFrameChanged();
+    Q_SIGNAL void playbackStatsChanged();
 
     // Q_INVOKABLE
     Q_INVOKABLE QVector4D pixelValueAt(int x, int y);
@@ -134,6 +257,72 @@ class FloatImageViewer : public QQuickItem
 
     QVariantList getCachedFrames() const;
 
+    int getPrefetchThreads() const { return _sequenceCache.getPrefetchingThreads(); }
+    void setPrefetchThreads(int nbThreads);
+
+    double getCacheBudget() const;
+    void setCacheBudget(double budget);
+
+    double getCacheRamRatio() const { return _sequenceCache.getCacheCapacityRatio(); }
+    void setCacheRamRatio(double ratio);
+
+    EEvictionPolicy getEvictionPolicy() const { return static_cast<EEvictionPolicy>(_sequenceCache.getEvictionPolicy()); }
+    void setEvictionPolicy(EEvictionPolicy policy);
+
+    const QVariantList& getPinnedFrames() const { return _pinnedFrames; }
+    void setPinnedFrames(const QVariantList& frames);
+
+    bool getHalfFloat() const { return _sequenceCache.getStorageMode() == imgserve::EStorageMode::Half; }
+    void setHalfFloat(bool halfFloat);
+
+    bool getProgressive() const { return _sequenceCache.getProgressive(); }
+    void setProgressive(bool progressive);
+
+    bool isProxy() const { return _proxy; }
+
+    bool getPersistentCache() const { return _sequenceCache.getPersistentCache(); }
+    void setPersistentCache(bool persistent);
+
+    qint64 getFrameBytesCopied() const { return _frameBytesCopied; }
+
+    bool getTiled() const { return _tiled; }
+    void setTiled(bool tiled);
+
+    const QUrl& getDisplayLut() const { return _displayLutSource; }
+    void setDisplayLut(const QUrl& source);
+
+    bool getScopesEnabled() const { return _scopesEnabled; }
+    void setScopesEnabled(bool enabled);
+
+    const QVariantList& getHistograms() const { return _histograms; }
+    const QVariantList& getWaveform() const { return _waveform; }
+    QSize getWaveformSize() const { return QSize(ImageScopes::waveformWidth, ImageScopes::waveformHeight); }
+    QVector4D getImageMinimum() const { return _scopes.minimum; }
+    QVector4D getImageMaximum() const { return _scopes.maximum; }
+    QVector4D getImageAverage() const { return _scopes.average; }
+
+    /**
+     * @brief Slot called when scopes have been computed in a worker thread.
+     * @param[in] scopes computed scopes
+     */
+    Q_SLOT void onScopesComputed(ImageScopes scopes);
+
+    double getFps() const { return _playbackClock.getFps(); }
+    void setFps(double fps);
+
+    int getLoopIn() const { return _loopIn; }
+    void setLoopIn(int frame);
+
+    int getLoopOut() const { return _loopOut; }
+    void setLoopOut(int frame);
+
+    bool isPlaying() const { return _playbackClock.isRunning(); }
+    void setPlaying(bool playing);
+
+    int getCurrentFrame() const { return _currentFrame; }
+
+    const QVariantMap& getPlaybackStats() const { return _playbackStats; }
+
   private:
     /// Reload image from source
     void reload();
@@ -143,6 +332,43 @@ class FloatImageViewer : public QQuickItem
 
     void updatePaintSurface(QSGGeometryNode* root, QSGSimpleMaterial<ShaderData>* material, QSGGeometry* geometryLine);
 
+    /**
+     * @brief Synchronize tile nodes with the displayed tiles.
+     * @param[in] tileRoot parent node of tile nodes
+     * @param[in] imageMaterial material of the image, whose parameters are applied to tiles
+     */
+    void updatePaintTiles(QSGNode* tileRoot, const QSGSimpleMaterial<ShaderData>* imageMaterial);
+
+    /// Select the tiles covering the viewport at the current zoom, requesting the missing ones
+    void updateTiles();
+
+    /// Check if tiles are displayed over the image
+    bool isTiling() const;
+
+    /// Compute scopes of the displayed image, once the computation in progress (if any) is done
+    void updateScopes();
+
+    /// Update the loop range of the playback clock from the loop frames and the sequence length
+    void updatePlaybackRange();
+
+    /**
+     * @brief Display a frame due during playback if it is in cache, otherwise skip it.
+     * @param[in] frame frame number in the sequence
+     */
+    void onFrameDue(int frame);
+
+    /// Publish playback statistics to QML and logs
+    void onPlaybackStatsChanged();
+
+    /// Notify QML that the budget of the shared image cache has changed, whichever viewer changed it
+    void onCacheCapacityChanged();
+
+    /// Check if an image is displayed, in either precision
+    bool hasImage() const { return _image || _halfImage; }
+
+    /// Dimensions of the displayed image
+    QSize imageSize() const;
+
     QUrl _source;
     float _gamma = 1.f;
     float _gain = 1.f;
@@ -154,6 +380,9 @@ class FloatImageViewer : public QQuickItem
     bool _imageChanged = false;
     EChannelMode _channelMode;
     std::shared_ptr<FloatImage> _image;
+    std::shared_ptr<HalfImage> _halfImage;
+    bool _proxy = false;
+    qint64 _frameBytesCopied = 0;
     QRectF _boundingRect;
     QSize _textureSize;
     QSize _sourceSize = QSize(0, 0);
@@ -170,9 +399,47 @@ class FloatImageViewer : public QQuickItem
 
     bool _cropFisheye = false;
 
+    QVariantList _pinnedFrames;
+
     imgserve::SequenceCache _sequenceCache;
     imgserve::SingleImageLoader _singleImageLoader;
     bool _useSequence = true;
+
+    /// Tile displayed over the image in tiled mode.
+    struct DisplayedTile
+    {
+        imgserve::TileKey key;
+        std::shared_ptr<FloatImage> image;
+        /// Area covered by the tile, in item coordinates.
+        QRectF rect;
+    };
+
+    bool _tiled = false;
+    QRectF _viewport;
+    imgserve::TileCache _tileCache;
+    std::vector<DisplayedTile> _tiles;
+
+    float _exposure = 0.f;
+    EDisplayMode _displayMode = EDisplayMode::Image;
+    float _zebraThreshold = 0.95f;
+    QUrl _displayLutSource;
+    std::shared_ptr<DisplayLut> _displayLut;
+    bool _displayLutChanged = false;
+
+    bool _scopesEnabled = false;
+    /// Scopes are being computed in a worker thread.
+    bool _scopesRunning = false;
+    /// Image or display parameters have changed during computation: compute again when done.
+    bool _scopesOutdated = false;
+    ImageScopes _scopes;
+    QVariantList _histograms;
+    QVariantList _waveform;
+
+    PlaybackClock _playbackClock;
+    int _loopIn = -1;
+    int _loopOut = -1;
+    int _currentFrame = -1;
+    QVariantMap _playbackStats;
 };
 
 }  // namespace qtAliceVision
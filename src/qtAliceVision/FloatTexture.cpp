@@ -1,34 +1,184 @@
 #include "FloatTexture.hpp"
-#include <aliceVision/image/resampling.hpp>
+#include "TexturePool.hpp"
 
 #include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
 #include <QOpenGLFunctions>
+#include <QQuickWindow>
+#include <QThreadPool>
 
 #include <QtDebug>
 
+#include <chrono>
+#include <cstring>
+
+#ifndef GL_HALF_FLOAT
+    #define GL_HALF_FLOAT 0x140B
+#endif
+#ifndef GL_PIXEL_UNPACK_BUFFER
+    #define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#endif
+#ifndef GL_STREAM_DRAW
+    #define GL_STREAM_DRAW 0x88E0
+#endif
+#ifndef GL_MAP_WRITE_BIT
+    #define GL_MAP_WRITE_BIT 0x0002
+#endif
+#ifndef GL_MAP_INVALIDATE_BUFFER_BIT
+    #define GL_MAP_INVALIDATE_BUFFER_BIT 0x0008
+#endif
+
 namespace qtAliceVision {
-int FloatTexture::_maxTextureSize = -1;
+std::atomic<int> FloatTexture::_maxTextureSize(-1);
 
 FloatTexture::FloatTexture() {}
 
+namespace {
+
+/// Check if pixel buffer objects can be mapped for writing (OpenGL 3.0 or OpenGL ES 3.0).
+bool hasMappablePixelBuffers(const QOpenGLContext* context) { return context->format().majorVersion() >= 3; }
+
+/// Threads copying pixels to mapped pixel buffers, shared by all textures.
+QThreadPool& copyThreadPool()
+{
+    static QThreadPool threadPool;
+    return threadPool;
+}
+
+}  // namespace
+
 FloatTexture::~FloatTexture()
 {
-    if (_textureId && QOpenGLContext::currentContext())
+    // The worker thread may still be writing to the mapped buffer
+    if (_pendingUpload.active)
+    {
+        _pendingUpload.copied.wait();
+    }
+    if (!_context)
     {
-        QOpenGLContext::currentContext()->functions()->glDeleteTextures(1, &_textureId);
+        return;
+    }
+    if (QOpenGLContext::currentContext() == _context)
+    {
+        releaseResources();
+    }
+    else
+    {
+        // GL calls are not possible without the context: the pool deletes the texture and the (possibly mapped) buffer later
+        TexturePool::forContext(_context).deleteLater(_textureId, _pixelBuffer);
     }
 }
 
+void FloatTexture::attachContext(QOpenGLContext* context)
+{
+    if (_context)
+    {
+        return;
+    }
+    _context = context;
+    QObject::connect(context, &QOpenGLContext::aboutToBeDestroyed, this, [this]() { deleteResources(); }, Qt::DirectConnection);
+}
+
+void FloatTexture::deleteResources()
+{
+    // The context is current: its pool may already be destroyed, GL objects are deleted directly
+    if (_pendingUpload.active)
+    {
+        _pendingUpload.copied.wait();
+        _pendingUpload = PendingUpload();
+    }
+    if (_textureId)
+    {
+        _context->functions()->glDeleteTextures(1, &_textureId);
+        _textureId = 0;
+    }
+    if (_pixelBuffer)
+    {
+        // Deleting a mapped buffer unmaps it
+        _context->functions()->glDeleteBuffers(1, &_pixelBuffer);
+        _pixelBuffer = 0;
+    }
+    _storageSize = QSize();
+    _storageType = 0;
+    _context = nullptr;
+
+    // Upload the image again if the texture is used with another context
+    _dirty = true;
+}
+
+int FloatTexture::queryMaxTextureSize()
+{
+    if (_maxTextureSize.load() == -1)
+    {
+        int maxTextureSize = -1;
+        QOpenGLContext::currentContext()->functions()->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+        _maxTextureSize.store(maxTextureSize);
+    }
+    return _maxTextureSize.load();
+}
+
+bool FloatTexture::fitsMaxTextureSize(const QSize& size)
+{
+    const int maxTextureSize = _maxTextureSize.load();
+    return maxTextureSize == -1 || (size.width() <= maxTextureSize && size.height() <= maxTextureSize);
+}
+
+void FloatTexture::releaseResources()
+{
+    QOpenGLContext* context = QOpenGLContext::currentContext();
+    if (!context || context != _context)
+    {
+        return;
+    }
+    cancelUpload();
+    if (_textureId && _storageType != 0)
+    {
+        // Keep texture storage for other textures of the same dimensions and format
+        TexturePool::forContext(context).release(_textureId, _storageSize, _storageType);
+        _textureId = 0;
+    }
+    else if (_textureId)
+    {
+        context->functions()->glDeleteTextures(1, &_textureId);
+        _textureId = 0;
+    }
+    if (_pixelBuffer)
+    {
+        context->functions()->glDeleteBuffers(1, &_pixelBuffer);
+        _pixelBuffer = 0;
+    }
+    _storageSize = QSize();
+    _storageType = 0;
+}
+
 void FloatTexture::setImage(std::shared_ptr<FloatImage>& image)
 {
     _srcImage = image;
+    _srcHalfImage.reset();
     _textureSize = {_srcImage->Width(), _srcImage->Height()};
     _dirty = true;
     _dirtyBindOptions = true;
     _mipmapsGenerated = false;
 }
 
-bool FloatTexture::isValid() const { return _srcImage->Width() != 0 && _srcImage->Height() != 0; }
+void FloatTexture::setImage(std::shared_ptr<HalfImage>& image)
+{
+    _srcHalfImage = image;
+    _srcImage.reset();
+    _textureSize = {_srcHalfImage->Width(), _srcHalfImage->Height()};
+    _dirty = true;
+    _dirtyBindOptions = true;
+    _mipmapsGenerated = false;
+}
+
+bool FloatTexture::isValid() const
+{
+    if (_srcHalfImage)
+    {
+        return _srcHalfImage->Width() != 0 && _srcHalfImage->Height() != 0;
+    }
+    return _srcImage && _srcImage->Width() != 0 && _srcImage->Height() != 0;
+}
 
 int FloatTexture::textureId() const
 {
@@ -40,7 +190,9 @@ int FloatTexture::textureId() const
         }
         else if (_textureId == 0)
         {
-            QOpenGLContext::currentContext()->functions()->glGenTextures(1, &const_cast<FloatTexture*>(this)->_textureId);
+            QOpenGLContext* context = QOpenGLContext::currentContext();
+            const_cast<FloatTexture*>(this)->attachContext(context);
+            context->functions()->glGenTextures(1, &const_cast<FloatTexture*>(this)->_textureId);
             return static_cast<int>(_textureId);
         }
     }
@@ -51,9 +203,14 @@ void FloatTexture::bind()
 {
     QOpenGLContext* context = QOpenGLContext::currentContext();
     QOpenGLFunctions* funcs = context->functions();
+    attachContext(context);
     if (!_dirty)
     {
         funcs->glBindTexture(GL_TEXTURE_2D, _textureId);
+        if (finishUpload())
+        {
+            _mipmapsGenerated = false;
+        }
         if (mipmapFiltering() != QSGTexture::None && !_mipmapsGenerated)
         {
             funcs->glGenerateMipmap(GL_TEXTURE_2D);
@@ -66,13 +223,12 @@ void FloatTexture::bind()
 
     _dirty = false;
 
+    // Pixels of the previous image are outdated
+    cancelUpload();
+
     if (!isValid())
     {
-        if (_textureId)
-        {
-            funcs->glDeleteTextures(1, &_textureId);
-        }
-        _textureId = 0;
+        releaseResources();
         _textureSize = QSize();
         return;
     }
@@ -85,26 +241,30 @@ void FloatTexture::bind()
         }
         funcs->glBindTexture(GL_TEXTURE_2D, _textureId);
 
-        // Init max texture size
-        if (_maxTextureSize == -1)
+        // Oversized images are downscaled at load time: never resample the source image, which may be shared
+        const int maxTextureSize = queryMaxTextureSize();
+        if (!fitsMaxTextureSize(_textureSize))
         {
-            funcs->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &_maxTextureSize);
+            qWarning() << "[QtAliceVision] Image is too large to be displayed:" << _textureSize << ", max texture size:" << maxTextureSize;
+            return;
         }
 
-        // Downscale the texture to fit inside the max texture limit if it is too big.
-        while (_maxTextureSize != -1 && (_srcImage->Width() > _maxTextureSize || _srcImage->Height() > _maxTextureSize))
-        {
-            FloatImage tmp;
-            aliceVision::image::ImageHalfSample(*_srcImage, tmp);
-            *_srcImage = std::move(tmp);
-        }
-        _textureSize = {_srcImage->Width(), _srcImage->Height()};
-
         updateBindOptions(_dirtyBindOptions);
 
-        funcs->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, _textureSize.width(), _textureSize.height(), 0, GL_RGBA, GL_FLOAT, _srcImage->data());
+        bool uploaded;
+        if (_srcHalfImage)
+        {
+            // Half float data matches the texture internal format: no conversion during upload
+            uploaded = upload(_srcHalfImage->data(), _srcHalfImage->memorySize(), GL_HALF_FLOAT, _srcHalfImage);
+        }
+        else
+        {
+            const std::size_t nbPixels = static_cast<std::size_t>(_srcImage->Width()) * static_cast<std::size_t>(_srcImage->Height());
+            const std::size_t nbBytes = nbPixels * 4 * sizeof(float);
+            uploaded = upload(_srcImage->data(), nbBytes, GL_FLOAT, _srcImage);
+        }
 
-        if (mipmapFiltering() != QSGTexture::None)
+        if (uploaded && mipmapFiltering() != QSGTexture::None)
         {
             funcs->glGenerateMipmap(GL_TEXTURE_2D);
             _mipmapsGenerated = true;
@@ -121,4 +281,162 @@ void FloatTexture::bind()
     }
 }
 
+bool FloatTexture::upload(const void* pixels, std::size_t nbBytes, unsigned int type, const std::shared_ptr<void>& source)
+{
+    QOpenGLContext* context = QOpenGLContext::currentContext();
+    QOpenGLFunctions* funcs = context->functions();
+    const bool reuseStorage = _storageSize == _textureSize && _storageType == type;
+
+    // Dimensions or format have changed: swap texture storage with the pool
+    if (_storageSize != _textureSize || _storageType != type)
+    {
+        TexturePool& pool = TexturePool::forContext(context);
+        unsigned int textureId = pool.acquire(_textureSize, type);
+        if (textureId != 0 || _storageType != 0)
+        {
+            // Current storage is kept for other textures of the same dimensions and format
+            if (_storageType != 0)
+            {
+                pool.release(_textureId, _storageSize, _storageType);
+            }
+            else
+            {
+                funcs->glDeleteTextures(1, &_textureId);
+            }
+
+            if (textureId != 0)
+            {
+                _storageSize = _textureSize;
+                _storageType = type;
+            }
+            else
+            {
+                funcs->glGenTextures(1, &textureId);
+                _storageSize = QSize();
+                _storageType = 0;
+            }
+            _textureId = textureId;
+
+            // Sampling parameters belong to texture objects
+            funcs->glBindTexture(GL_TEXTURE_2D, _textureId);
+            updateBindOptions(true);
+        }
+    }
+
+    // Stage pixels in a pixel buffer object: the transfer to the texture is then performed asynchronously by the driver.
+    // The buffer is orphaned before being mapped, so that filling it never waits for the previous transfer.
+    const void* data = pixels;
+    bool pixelBufferBound = false;
+    if (hasMappablePixelBuffers(context))
+    {
+        QOpenGLExtraFunctions* extraFuncs = context->extraFunctions();
+        if (_pixelBuffer == 0)
+        {
+            funcs->glGenBuffers(1, &_pixelBuffer);
+        }
+
+        const auto size = static_cast<qopengl_GLsizeiptr>(nbBytes);
+        funcs->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pixelBuffer);
+        funcs->glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        void* mapped = extraFuncs->glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+        if (mapped && _window && reuseStorage)
+        {
+            // Texture content is kept until the next frame: pixels are copied in a worker thread and uploaded then
+            QQuickWindow* window = _window;
+            auto copy = std::make_shared<std::packaged_task<void()>>([mapped, pixels, nbBytes, window]() {
+                std::memcpy(mapped, pixels, nbBytes);
+                QMetaObject::invokeMethod(window, "update", Qt::QueuedConnection);
+            });
+            _pendingUpload.active = true;
+            _pendingUpload.copied = copy->get_future();
+            _pendingUpload.source = source;
+            _pendingUpload.pixels = pixels;
+            _pendingUpload.type = type;
+            copyThreadPool().start([copy]() { (*copy)(); });
+
+            // The buffer stays mapped until the copy is done
+            funcs->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            return false;
+        }
+
+        if (mapped)
+        {
+            std::memcpy(mapped, pixels, nbBytes);
+            pixelBufferBound = extraFuncs->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+        }
+        if (pixelBufferBound)
+        {
+            // Pixels are now read from the bound buffer, at offset 0
+            data = nullptr;
+        }
+        else
+        {
+            // Fallback to a direct upload from client memory
+            funcs->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+    }
+
+    if (_storageSize == _textureSize && _storageType == type)
+    {
+        // Same dimensions and format: only replace texture content
+        funcs->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _textureSize.width(), _textureSize.height(), GL_RGBA, type, data);
+    }
+    else
+    {
+        funcs->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, _textureSize.width(), _textureSize.height(), 0, GL_RGBA, type, data);
+        _storageSize = _textureSize;
+        _storageType = type;
+    }
+
+    if (pixelBufferBound)
+    {
+        funcs->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    return true;
+}
+
+bool FloatTexture::finishUpload()
+{
+    if (!_pendingUpload.active || _pendingUpload.copied.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        return false;
+    }
+
+    QOpenGLContext* context = QOpenGLContext::currentContext();
+    QOpenGLFunctions* funcs = context->functions();
+
+    // Pixels are read from the buffer once unmapped, or from client memory if the buffer content has been lost
+    funcs->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pixelBuffer);
+    const bool pixelBufferBound = context->extraFunctions()->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+    if (!pixelBufferBound)
+    {
+        funcs->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    const void* data = pixelBufferBound ? nullptr : _pendingUpload.pixels;
+    funcs->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _textureSize.width(), _textureSize.height(), GL_RGBA, _pendingUpload.type, data);
+    if (pixelBufferBound)
+    {
+        funcs->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    _pendingUpload = PendingUpload();
+    return true;
+}
+
+void FloatTexture::cancelUpload()
+{
+    if (!_pendingUpload.active)
+    {
+        return;
+    }
+
+    _pendingUpload.copied.wait();
+    QOpenGLContext* context = QOpenGLContext::currentContext();
+    context->functions()->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pixelBuffer);
+    context->extraFunctions()->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    context->functions()->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    _pendingUpload = PendingUpload();
+}
+
 }  // namespace qtAliceVision
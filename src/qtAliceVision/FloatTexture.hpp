@@ -1,19 +1,37 @@
 #pragma once
 
+#include "HalfImage.hpp"
+
 #include <aliceVision/image/Image.hpp>
 #include <aliceVision/image/pixelTypes.hpp>
 #include <aliceVision/types.hpp>
 
 #include <QSGTexture>
 
+#include <atomic>
+#include <cstddef>
+#include <future>
 #include <memory>
 
+class QOpenGLContext;
+class QQuickWindow;
+
 namespace qtAliceVision {
 
 using FloatImage = aliceVision::image::Image<aliceVision::image::RGBAfColor>;
 
 /**
  * @brief A custom QSGTexture to display AliceVision images in QML
+ *
+ * Pixels are streamed to the GPU through a pixel buffer object when the context supports it.
+ * When a new image of the same dimensions and format is set on a texture attached to a window, the render thread only maps the buffer:
+ * pixels are copied into it by a worker thread, then uploaded at the next frame, which the window is asked to render.
+ * Render thread time per image is then independent of image size, the previous image being displayed until the next frame.
+ * A single pixel buffer is used per texture, without double buffering: it is orphaned before being mapped,
+ * so that the driver provides new storage while the previous transfer is pending.
+ * Texture storage is reused when a new image of the same dimensions and format is set,
+ * otherwise it is exchanged with the TexturePool of the context, so that textures are rarely allocated during playback.
+ * GL objects are deleted when the context is destroyed, or by the pool if the texture is destroyed while the context is not current.
  */
 class FloatTexture : public QSGTexture
 {
@@ -32,31 +50,110 @@ class FloatTexture : public QSGTexture
     void setImage(std::shared_ptr<FloatImage>& image);
     const FloatImage& image() { return *_srcImage; }
 
+    /**
+     * @brief Set a half float image, uploaded as is without conversion to float.
+     * @param[in] image half float image
+     */
+    void setImage(std::shared_ptr<HalfImage>& image);
+
+    /**
+     * @brief Set the window rendering the texture, enabling uploads of pixels copied off the render thread.
+     * @param[in] window window updated when copied pixels are ready to be uploaded (may be null)
+     * @note must be called from the render thread, the window must outlive the texture
+     */
+    void setWindow(QQuickWindow* window) { _window = window; }
+
     void bind() override;
 
     /**
      * @brief Get the maximum dimension of a texture.
      *
-     * If the provided image is too large, it will be downscaled to fit the max dimension.
+     * Images larger than the max dimension are not displayed: they must be downscaled when loaded, off the render thread.
+     * The provided image is never modified, as it may be shared with an image cache.
      *
      * @return -1 if unknown else the max size of a texture
      */
-    static int maxTextureSize() { return _maxTextureSize; }
+    static int maxTextureSize() { return _maxTextureSize.load(); }
+
+    /**
+     * @brief Retrieve the maximum dimension of a texture from the current OpenGL context if it is not known yet.
+     * @note must be called from the render thread
+     * @return the max size of a texture
+     */
+    static int queryMaxTextureSize();
+
+    /**
+     * @brief Check if an image can be uploaded in a texture.
+     * @param[in] size image dimensions
+     * @return true if the dimensions fit the max texture size (or if it is unknown), otherwise false
+     */
+    static bool fitsMaxTextureSize(const QSize& size);
 
   private:
     bool isValid() const;
 
+    /**
+     * @brief Upload pixels to the bound texture, reusing its storage if possible.
+     * @param[in] pixels RGBA pixel data, of size _textureSize
+     * @param[in] nbBytes size of pixel data, in bytes
+     * @param[in] type GL type of pixel components
+     * @param[in] source owner of pixel data, kept alive while pixels are copied in a worker thread
+     * @return false if pixels are being copied in a worker thread, to be uploaded by finishUpload at a later frame
+     */
+    bool upload(const void* pixels, std::size_t nbBytes, unsigned int type, const std::shared_ptr<void>& source);
+
+    /// Upload pixels copied in a worker thread to the bound texture, if the copy is done.
+    /// @return true if pixels have been uploaded
+    bool finishUpload();
+
+    /// Wait for pixels being copied in a worker thread and discard them.
+    void cancelUpload();
+
+    /// Delete GL objects owned by the texture, if any, giving texture storage back to the pool.
+    /// Nothing is done if the context of the texture is not current.
+    void releaseResources();
+
+    /// Set the context owning GL objects of the texture, deleting them when the context is destroyed.
+    void attachContext(QOpenGLContext* context);
+
+    /// Delete GL objects owned by the texture without the pool, the context being about to be destroyed.
+    void deleteResources();
+
   private:
     std::shared_ptr<FloatImage> _srcImage;
+    std::shared_ptr<HalfImage> _srcHalfImage;
+
+    /// Context owning GL objects of the texture.
+    QOpenGLContext* _context = nullptr;
 
     unsigned int _textureId = 0;
     QSize _textureSize;
 
+    /// Dimensions and pixel type of the allocated texture storage.
+    QSize _storageSize;
+    unsigned int _storageType = 0;
+
+    /// Pixel buffer object used for uploads.
+    unsigned int _pixelBuffer = 0;
+
+    /// Pixels being copied into the mapped pixel buffer by a worker thread.
+    struct PendingUpload
+    {
+        bool active = false;
+        std::future<void> copied;
+        std::shared_ptr<void> source;
+        const void* pixels = nullptr;
+        unsigned int type = 0;
+    };
+    PendingUpload _pendingUpload;
+
+    QQuickWindow* _window = nullptr;
+
     bool _dirty = false;
     bool _dirtyBindOptions = false;
     bool _mipmapsGenerated = false;
 
-    static int _maxTextureSize;
+    static std::atomic<int> _maxTextureSize;
 };
 
 }  // namespace qtAliceVision
@@ -0,0 +1,181 @@
+#include "HalfImage.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace qtAliceVision {
+
+uint16_t floatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const uint32_t absBits = bits & 0x7FFFFFFFu;
+
+    // Infinity or NaN (keep NaNs quiet)
+    if (absBits >= 0x7F800000u)
+    {
+        return static_cast<uint16_t>(sign | 0x7C00u | (absBits > 0x7F800000u ? 0x200u : 0u));
+    }
+
+    // Too large: rounds to infinity
+    if (absBits >= 0x477FF000u)
+    {
+        return static_cast<uint16_t>(sign | 0x7C00u);
+    }
+
+    // Too small for a normal half: subnormal or zero
+    if (absBits < 0x38800000u)
+    {
+        if (absBits < 0x33000000u)
+        {
+            return static_cast<uint16_t>(sign);
+        }
+
+        const uint32_t exponent = absBits >> 23;
+        const uint32_t mantissa = (absBits & 0x7FFFFFu) | 0x800000u;
+        const uint32_t shift = 126u - exponent;
+
+        uint32_t result = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1u);
+        const uint32_t halfway = 1u << (shift - 1u);
+        if (remainder > halfway || (remainder == halfway && (result & 1u)))
+        {
+            ++result;
+        }
+        return static_cast<uint16_t>(sign | result);
+    }
+
+    // Normal: rebias exponent and round mantissa (a carry correctly propagates to the exponent)
+    uint32_t result = (absBits - 0x38000000u) >> 13;
+    const uint32_t remainder = absBits & 0x1FFFu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (result & 1u)))
+    {
+        ++result;
+    }
+    return static_cast<uint16_t>(sign | result);
+}
+
+float halfToFloat(uint16_t value)
+{
+    const uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+    uint32_t exponent = (value >> 10) & 0x1Fu;
+    uint32_t mantissa = value & 0x3FFu;
+
+    uint32_t bits;
+    if (exponent == 0x1Fu)
+    {
+        // Infinity or NaN
+        bits = sign | 0x7F800000u | (mantissa << 13);
+    }
+    else if (exponent == 0)
+    {
+        if (mantissa == 0)
+        {
+            bits = sign;
+        }
+        else
+        {
+            // Subnormal: normalize
+            exponent = 113;
+            while (!(mantissa & 0x400u))
+            {
+                mantissa <<= 1;
+                --exponent;
+            }
+            mantissa &= 0x3FFu;
+            bits = sign | (exponent << 23) | (mantissa << 13);
+        }
+    }
+    else
+    {
+        bits = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+    }
+
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+HalfImage::HalfImage(const aliceVision::image::Image<aliceVision::image::RGBAfColor>& img)
+{
+    allocate(img.Width(), img.Height());
+
+    std::size_t idx = 0;
+    for (int y = 0; y < _height; ++y)
+    {
+        for (int x = 0; x < _width; ++x)
+        {
+            const aliceVision::image::RGBAfColor& color = img(y, x);
+            _data[idx++] = floatToHalf(color.r());
+            _data[idx++] = floatToHalf(color.g());
+            _data[idx++] = floatToHalf(color.b());
+            _data[idx++] = floatToHalf(color.a());
+        }
+    }
+}
+
+HalfImage::HalfImage(int width, int height, const std::shared_ptr<PixelBuffer>& buffer)
+  : _width(width),
+    _height(height),
+    _buffer(buffer),
+    _data(reinterpret_cast<uint16_t*>(buffer->data()))
+{}
+
+void HalfImage::allocate(int width, int height)
+{
+    _width = width;
+    _height = height;
+    _buffer = PixelBuffer::allocate(static_cast<std::size_t>(memorySize()));
+    _data = reinterpret_cast<uint16_t*>(_buffer->data());
+}
+
+void HalfImage::toFloat(aliceVision::image::Image<aliceVision::image::RGBAfColor>& img) const
+{
+    img.resize(_width, _height);
+    for (int y = 0; y < _height; ++y)
+    {
+        for (int x = 0; x < _width; ++x)
+        {
+            img(y, x) = (*this)(y, x);
+        }
+    }
+}
+
+aliceVision::image::RGBAfColor HalfImage::operator()(int y, int x) const
+{
+    const std::size_t idx = (static_cast<std::size_t>(y) * static_cast<std::size_t>(_width) + static_cast<std::size_t>(x)) * 4;
+    return aliceVision::image::RGBAfColor(
+      halfToFloat(_data[idx]), halfToFloat(_data[idx + 1]), halfToFloat(_data[idx + 2]), halfToFloat(_data[idx + 3]));
+}
+
+HalfImage HalfImage::halfSampled() const
+{
+    HalfImage result;
+    result.allocate(std::max(1, _width / 2), std::max(1, _height / 2));
+
+    std::size_t idx = 0;
+    for (int y = 0; y < result._height; ++y)
+    {
+        const int y0 = std::min(2 * y, _height - 1);
+        const int y1 = std::min(2 * y + 1, _height - 1);
+        for (int x = 0; x < result._width; ++x)
+        {
+            const int x0 = std::min(2 * x, _width - 1);
+            const int x1 = std::min(2 * x + 1, _width - 1);
+            const aliceVision::image::RGBAfColor c00 = (*this)(y0, x0);
+            const aliceVision::image::RGBAfColor c01 = (*this)(y0, x1);
+            const aliceVision::image::RGBAfColor c10 = (*this)(y1, x0);
+            const aliceVision::image::RGBAfColor c11 = (*this)(y1, x1);
+            for (int c = 0; c < 4; ++c)
+            {
+                result._data[idx++] = floatToHalf(0.25f * (c00(c) + c01(c) + c10(c) + c11(c)));
+            }
+        }
+    }
+
+    return result;
+}
+
+}  // namespace qtAliceVision
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "PixelBuffer.hpp"
+
+#include <aliceVision/image/Image.hpp>
+#include <aliceVision/image/pixelTypes.hpp>
+
+#include <cstdint>
+#include <memory>
+
+namespace qtAliceVision {
+
+/**
+ * @brief Convert a 32-bit float to the bit pattern of a 16-bit (IEEE 754 binary16) float.
+ * @note rounds to nearest even, out of range values become infinities
+ */
+uint16_t floatToHalf(float value);
+
+/**
+ * @brief Convert the bit pattern of a 16-bit (IEEE 754 binary16) float to a 32-bit float.
+ */
+float halfToFloat(uint16_t value);
+
+/**
+ * @brief RGBA image with 16-bit floating point channels.
+ *
+ * Uses half the memory of an Image<RGBAfColor>, with enough precision for display purposes.
+ * Pixels are stored row by row as interleaved RGBA binary16 values, ready for upload as GL_HALF_FLOAT,
+ * in a page-aligned or file-mapped PixelBuffer that is never modified once the image is built:
+ * copies of an image share the same pixel data.
+ */
+class HalfImage
+{
+  public:
+    HalfImage() = default;
+
+    /**
+     * @brief Build a half float image by converting a float image.
+     * @param[in] img source image
+     */
+    explicit HalfImage(const aliceVision::image::Image<aliceVision::image::RGBAfColor>& img);
+
+    /**
+     * @brief Build a half float image on existing pixel data, without copying it.
+     * @param[in] width image width
+     * @param[in] height image height
+     * @param[in] buffer interleaved RGBA binary16 values, row by row (at least width * height * 8 bytes)
+     */
+    HalfImage(int width, int height, const std::shared_ptr<PixelBuffer>& buffer);
+
+    int Width() const { return _width; }
+
+    int Height() const { return _height; }
+
+    /// Raw interleaved RGBA data.
+    const uint16_t* data() const { return _data; }
+
+    /// Memory used by pixel data, in bytes.
+    uint64_t memorySize() const { return static_cast<uint64_t>(_width) * static_cast<uint64_t>(_height) * 4 * sizeof(uint16_t); }
+
+    /// Check if pixel data is mapped from a file.
+    bool isMapped() const { return _buffer && _buffer->isMapped(); }
+
+    /**
+     * @brief Get a pixel value converted to float.
+     * @param[in] y row
+     * @param[in] x column
+     */
+    aliceVision::image::RGBAfColor operator()(int y, int x) const;
+
+    /**
+     * @brief Convert to a float image.
+     * @param[out] img converted image
+     */
+    void toFloat(aliceVision::image::Image<aliceVision::image::RGBAfColor>& img) const;
+
+    /**
+     * @brief Build an image of half the resolution using a 2x2 box filter.
+     */
+    HalfImage halfSampled() const;
+
+  private:
+    /// Allocate pixel data for the given dimensions.
+    void allocate(int width, int height);
+
+    int _width = 0;
+    int _height = 0;
+    std::shared_ptr<PixelBuffer> _buffer;
+    uint16_t* _data = nullptr;
+};
+
+}  // namespace qtAliceVision
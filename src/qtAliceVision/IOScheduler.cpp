@@ -0,0 +1,241 @@
+#include "IOScheduler.hpp"
+
+#include <QThread>
+
+#include <algorithm>
+
+namespace qtAliceVision {
+
+namespace {
+
+/// Names of task classes in metrics, in priority order.
+const char* const classNames[] = {"interactive", "analysis", "background"};
+
+}  // namespace
+
+/**
+ * @brief Runnable wrapping a scheduled task, releasing its slot to the scheduler when done.
+ */
+class IOScheduler::ScheduledRunnable : public QRunnable
+{
+  public:
+    ScheduledRunnable(IOScheduler& scheduler, EIOClass ioClass, QRunnable* runnable, const void* owner)
+      : _scheduler(scheduler),
+        _ioClass(ioClass),
+        _runnable(runnable),
+        _owner(owner)
+    {}
+
+    void run() override
+    {
+        _runnable->run();
+        if (_runnable->autoDelete())
+        {
+            delete _runnable;
+        }
+        _scheduler.onTaskDone(_ioClass, _owner);
+    }
+
+  private:
+    IOScheduler& _scheduler;
+    EIOClass _ioClass;
+    QRunnable* _runnable;
+    const void* _owner;
+};
+
+IOScheduler& IOScheduler::instance()
+{
+    static IOScheduler scheduler;
+    return scheduler;
+}
+
+IOScheduler::IOScheduler()
+{
+    // Leave threads for sequence prefetching, which has its own pools
+    _maxThreads = std::max(2, QThread::idealThreadCount() / 2);
+    _threadPool.setMaxThreadCount(_maxThreads);
+
+    // Interactive loads can use all threads, background tasks at most half of them
+    _classes[static_cast<std::size_t>(EIOClass::Interactive)].concurrency = _maxThreads;
+    _classes[static_cast<std::size_t>(EIOClass::Analysis)].concurrency = 1;
+    _classes[static_cast<std::size_t>(EIOClass::Background)].concurrency = std::max(1, _maxThreads / 2);
+}
+
+IOScheduler::~IOScheduler()
+{
+    // Release queued tasks and wait for running ones
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (ClassState& state : _classes)
+        {
+            for (const Task& task : state.queue)
+            {
+                if (task.runnable->autoDelete())
+                {
+                    delete task.runnable;
+                }
+            }
+            state.queue.clear();
+        }
+    }
+    _threadPool.waitForDone();
+}
+
+void IOScheduler::start(EIOClass ioClass, QRunnable* runnable, const void* owner, int ownerConcurrency)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ClassState& state = _classes[static_cast<std::size_t>(ioClass)];
+        state.queue.push_back({runnable, owner, ownerConcurrency});
+        state.peakQueueDepth = std::max(state.peakQueueDepth, static_cast<int>(state.queue.size()));
+        dispatch();
+    }
+    Q_EMIT metricsChanged();
+}
+
+void IOScheduler::cancel(const void* owner)
+{
+    if (!owner)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (ClassState& state : _classes)
+        {
+            auto isOwned = [owner](const Task& task) { return task.owner == owner; };
+            for (const Task& task : state.queue)
+            {
+                if (isOwned(task) && task.runnable->autoDelete())
+                {
+                    delete task.runnable;
+                }
+            }
+            state.queue.erase(std::remove_if(state.queue.begin(), state.queue.end(), isOwned), state.queue.end());
+        }
+    }
+    Q_EMIT metricsChanged();
+}
+
+void IOScheduler::setMaxThreads(int nbThreads)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _maxThreads = std::max(1, nbThreads);
+        _threadPool.setMaxThreadCount(_maxThreads);
+        for (ClassState& state : _classes)
+        {
+            state.concurrency = std::min(state.concurrency, _maxThreads);
+        }
+        dispatch();
+    }
+    Q_EMIT metricsChanged();
+}
+
+int IOScheduler::getMaxThreads() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _maxThreads;
+}
+
+void IOScheduler::setConcurrency(EIOClass ioClass, int nbThreads)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _classes[static_cast<std::size_t>(ioClass)].concurrency = std::clamp(nbThreads, 1, _maxThreads);
+        dispatch();
+    }
+    Q_EMIT metricsChanged();
+}
+
+int IOScheduler::getConcurrency(EIOClass ioClass) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _classes[static_cast<std::size_t>(ioClass)].concurrency;
+}
+
+int IOScheduler::getQueueDepth(EIOClass ioClass) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return static_cast<int>(_classes[static_cast<std::size_t>(ioClass)].queue.size());
+}
+
+QVariantMap IOScheduler::getMetrics() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    QVariantMap metrics;
+    for (std::size_t i = 0; i < _classes.size(); ++i)
+    {
+        const ClassState& state = _classes[i];
+        QVariantMap classMetrics;
+        classMetrics.insert("queueDepth", static_cast<int>(state.queue.size()));
+        classMetrics.insert("running", state.running);
+        classMetrics.insert("concurrency", state.concurrency);
+        classMetrics.insert("peakQueueDepth", state.peakQueueDepth);
+        classMetrics.insert("completed", static_cast<qulonglong>(state.completed));
+        metrics.insert(classNames[i], classMetrics);
+    }
+    return metrics;
+}
+
+void IOScheduler::dispatch()
+{
+    // Fill available threads by decreasing priority
+    for (std::size_t i = 0; i < _classes.size() && _running < _maxThreads; ++i)
+    {
+        ClassState& state = _classes[i];
+        auto it = state.queue.begin();
+        while (it != state.queue.end() && state.running < state.concurrency && _running < _maxThreads)
+        {
+            // Tasks of owners at their concurrency limit wait, later tasks of other owners may start
+            if (!isOwnerAvailable(*it))
+            {
+                ++it;
+                continue;
+            }
+
+            const Task task = *it;
+            it = state.queue.erase(it);
+            ++state.running;
+            ++_running;
+            if (task.owner)
+            {
+                ++_ownerRunning[task.owner];
+            }
+            _threadPool.start(new ScheduledRunnable(*this, static_cast<EIOClass>(i), task.runnable, task.owner));
+        }
+    }
+}
+
+bool IOScheduler::isOwnerAvailable(const Task& task) const
+{
+    if (!task.owner || task.ownerConcurrency <= 0)
+    {
+        return true;
+    }
+    const auto it = _ownerRunning.find(task.owner);
+    return it == _ownerRunning.end() || it->second < task.ownerConcurrency;
+}
+
+void IOScheduler::onTaskDone(EIOClass ioClass, const void* owner)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ClassState& state = _classes[static_cast<std::size_t>(ioClass)];
+        --state.running;
+        ++state.completed;
+        --_running;
+        if (owner && --_ownerRunning[owner] == 0)
+        {
+            _ownerRunning.erase(owner);
+        }
+        dispatch();
+    }
+    Q_EMIT metricsChanged();
+}
+
+}  // namespace qtAliceVision
+
+#include "IOScheduler.moc"
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <QObject>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QVariant>
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace qtAliceVision {
+
+/**
+ * @brief Process-wide scheduler of the asynchronous tasks of qtAliceVision loaders.
+ *
+ * Tasks are sorted in classes, by decreasing priority: whenever a thread is available,
+ * it runs the oldest queued task of the highest priority class that has not reached its concurrency limit.
+ * Lower priority classes are limited to a share of the threads, so that long background tasks
+ * (e.g. building tracks) never starve images the user is waiting for.
+ *
+ * Prefetching and metadata scans of image sequences are not scheduled here:
+ * SequenceCache sizes its own pools from the prefetching threads setting.
+ */
+class IOScheduler : public QObject
+{
+    Q_OBJECT
+
+    /// Queue depth, running tasks, concurrency limit, peak queue depth and completed tasks of each class
+    Q_PROPERTY(QVariantMap metrics READ getMetrics NOTIFY metricsChanged)
+
+    /// Maximum number of tasks running at once, all classes included
+    Q_PROPERTY(int maxThreads READ getMaxThreads WRITE setMaxThreads NOTIFY metricsChanged)
+
+  public:
+    /// Task classes, by decreasing priority.
+    enum class EIOClass : quint8
+    {
+        /// Image loads the user is waiting for (single images, tiles, proxies).
+        Interactive,
+        /// Image analysis for display (scopes).
+        Analysis,
+        /// Reconstruction data (features, tracks, SfM data).
+        Background
+    };
+    Q_ENUM(EIOClass)
+
+    /// Get the process-wide scheduler.
+    static IOScheduler& instance();
+
+    ~IOScheduler() override;
+
+    /**
+     * @brief Queue a task.
+     * @param[in] ioClass class of the task
+     * @param[in] runnable task, deleted after running if auto-deletion is enabled
+     * @param[in] owner identifier of the client queuing the task, used for cancellation (may be null)
+     * @param[in] ownerConcurrency maximum number of tasks of the owner running at once (0 for no limit),
+     *            e.g. 1 for clients whose superseded tasks must not compete with their latest one
+     */
+    void start(EIOClass ioClass, QRunnable* runnable, const void* owner = nullptr, int ownerConcurrency = 0);
+
+    /**
+     * @brief Remove the queued tasks of a client, tasks already running are not interrupted.
+     * @param[in] owner identifier of the client given when queuing tasks
+     */
+    void cancel(const void* owner);
+
+    /**
+     * @brief Set the maximum number of tasks running at once, all classes included.
+     * @param[in] nbThreads number of threads (at least 1), concurrency limits of classes are capped accordingly
+     */
+    void setMaxThreads(int nbThreads);
+
+    /// Get the maximum number of tasks running at once, all classes included.
+    int getMaxThreads() const;
+
+    /**
+     * @brief Set the maximum number of tasks of a class running at once.
+     * @param[in] ioClass task class
+     * @param[in] nbThreads number of threads, in [1, maxThreads]
+     */
+    Q_INVOKABLE void setConcurrency(EIOClass ioClass, int nbThreads);
+
+    /// Get the maximum number of tasks of a class running at once.
+    Q_INVOKABLE int getConcurrency(EIOClass ioClass) const;
+
+    /// Get the number of queued tasks of a class, waiting for a thread.
+    Q_INVOKABLE int getQueueDepth(EIOClass ioClass) const;
+
+    QVariantMap getMetrics() const;
+
+    /// Signal emitted when tasks are queued, started or finished, or when limits change (possibly from a worker thread).
+    Q_SIGNAL void metricsChanged();
+
+  private:
+    class ScheduledRunnable;
+
+    struct Task
+    {
+        QRunnable* runnable;
+        const void* owner;
+        int ownerConcurrency;
+    };
+
+    /// Scheduling state of a task class.
+    struct ClassState
+    {
+        std::deque<Task> queue;
+        int running = 0;
+        int concurrency = 1;
+        int peakQueueDepth = 0;
+        uint64_t completed = 0;
+    };
+
+    IOScheduler();
+
+    /// Start queued tasks while threads are available (called with the mutex locked).
+    void dispatch();
+
+    /// Check if a queued task can start without exceeding the concurrency limit of its owner (called with the mutex locked).
+    bool isOwnerAvailable(const Task& task) const;
+
+    /// Called by worker threads when a task is done.
+    void onTaskDone(EIOClass ioClass, const void* owner);
+
+    mutable std::mutex _mutex;
+    std::array<ClassState, 3> _classes;
+    int _maxThreads;
+    int _running = 0;
+
+    /// Number of running tasks of each owner.
+    std::unordered_map<const void*, int> _ownerRunning;
+
+    /// Threads running the tasks, sized to the maximum number of tasks running at once.
+    QThreadPool _threadPool;
+};
+
+}  // namespace qtAliceVision
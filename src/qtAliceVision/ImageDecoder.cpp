@@ -0,0 +1,345 @@
+#include "ImageDecoder.hpp"
+
+#include <OpenImageIO/imageio.h>
+#include <OpenImageIO/strutil.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace qtAliceVision {
+namespace imgserve {
+
+namespace {
+
+/// Transfer function of pixel values stored in a file.
+enum class ETransfer
+{
+    Linear,
+    SRGB
+};
+
+/// Memory used by the pixels of an image, in bytes.
+uint64_t imageSize(const aliceVision::image::Image<aliceVision::image::RGBAfColor>& img)
+{
+    return static_cast<uint64_t>(img.Width()) * static_cast<uint64_t>(img.Height()) * sizeof(aliceVision::image::RGBAfColor);
+}
+
+float srgbToLinear(float v) { return (v <= 0.04045f) ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f); }
+
+/// Linear values of 8-bit sRGB codes.
+const std::array<float, 256>& srgbTable()
+{
+    static const std::array<float, 256> table = []() {
+        std::array<float, 256> values;
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            values[i] = srgbToLinear(static_cast<float>(i) / 255.f);
+        }
+        return values;
+    }();
+    return table;
+}
+
+/**
+ * @brief Find the transfer function of an image, from the same color space attributes as aliceVision::image::readImage.
+ * @param[in] spec image specification
+ * @param[out] transfer transfer function
+ * @return false if the color space requires a conversion that is not a transfer function
+ */
+bool getTransfer(const oiio::ImageSpec& spec, ETransfer& transfer)
+{
+    const std::string colorSpace = spec.get_string_attribute("AliceVision:ColorSpace", spec.get_string_attribute("oiio:ColorSpace", "sRGB"));
+
+    if (oiio::Strutil::iequals(colorSpace, "sRGB"))
+    {
+        transfer = ETransfer::SRGB;
+        return true;
+    }
+    if (oiio::Strutil::iequals(colorSpace, "Linear") || oiio::Strutil::iequals(colorSpace, "lin_rec709") ||
+        oiio::Strutil::iequals(colorSpace, "scene_linear"))
+    {
+        transfer = ETransfer::Linear;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Open an image that can be read without AliceVision, from MIP levels and streaming box filtering.
+ * @param[out] transfer transfer function of the image
+ * @return the opened image, null if it cannot be read this way
+ */
+std::unique_ptr<oiio::ImageInput> openReducible(const std::string& path, ETransfer& transfer)
+{
+    std::unique_ptr<oiio::ImageInput> input = oiio::ImageInput::open(path);
+    if (!input)
+    {
+        return nullptr;
+    }
+
+    // RAW files need AliceVision's demosaicing and color settings
+    if (std::string(input->format_name()) == "raw")
+    {
+        return nullptr;
+    }
+
+    if (input->spec().nchannels < 1 || !getTransfer(input->spec(), transfer))
+    {
+        return nullptr;
+    }
+    return input;
+}
+
+/**
+ * @brief Read a region of an image at a reduced resolution, from MIP levels and streaming box filtering.
+ * @param[in] region output region in downscaled image coordinates, clamped to the image
+ * @param[in] cancel flag stopping the read between output rows when set, leaving the image incomplete (may be null)
+ * @return false if the image cannot be read this way
+ * @throw std::runtime_error if the image cannot be read from disk
+ */
+bool decodeReduced(const std::string& path,
+                   int downscale,
+                   const Region& region,
+                   aliceVision::image::Image<aliceVision::image::RGBAfColor>& img,
+                   const std::atomic_bool* cancel = nullptr)
+{
+    ETransfer transfer;
+    std::unique_ptr<oiio::ImageInput> input = openReducible(path, transfer);
+    if (!input)
+    {
+        return false;
+    }
+
+    // Downscaled image dimensions, identical to imageAlgo::resizeImage
+    const int fullWidth = std::max(1, input->spec().width / downscale);
+    const int fullHeight = std::max(1, input->spec().height / downscale);
+
+    // Output region
+    const int xOffset = std::clamp(region.x, 0, fullWidth);
+    const int yOffset = std::clamp(region.y, 0, fullHeight);
+    const int width = std::clamp(region.width, 0, fullWidth - xOffset);
+    const int height = std::clamp(region.height, 0, fullHeight - yOffset);
+
+    // Use the coarsest MIP level whose scale divides the downscale factor
+    int level = 0;
+    while (downscale % (2 << level) == 0 && input->seek_subimage(0, level + 1))
+    {
+        ++level;
+    }
+    if (!input->seek_subimage(0, level))
+    {
+        throw std::runtime_error("Failed to read image '" + path + "': " + input->geterror());
+    }
+    const oiio::ImageSpec& spec = input->spec();
+    const int factor = downscale >> level;
+
+    // Map file channels to RGBA
+    const int nbChannels = std::min(spec.nchannels, 4);
+    const int green = (nbChannels >= 3) ? 1 : 0;
+    const int blue = (nbChannels >= 3) ? 2 : 0;
+    int alpha = (nbChannels == 2 || nbChannels == 4) ? nbChannels - 1 : -1;
+    if (spec.alpha_channel >= 0 && spec.alpha_channel < nbChannels)
+    {
+        alpha = spec.alpha_channel;
+    }
+
+    // 8-bit sRGB values are linearized with a lookup table
+    const bool useTable = transfer == ETransfer::SRGB && spec.format == oiio::TypeDesc::UINT8;
+
+    // Columns of the file contributing to the region
+    // Scanline files are always read full width, tiled files only from the tiles covering the region
+    const bool tiled = spec.tile_width > 0 && spec.tile_height > 0;
+    int xRead = 0;
+    int xReadEnd = spec.width;
+    if (tiled)
+    {
+        const int xFirst = std::min(xOffset * factor, spec.width - 1);
+        const int xLast = std::min((xOffset + width) * factor, spec.width);
+        xRead = xFirst / spec.tile_width * spec.tile_width;
+        xReadEnd = std::min((xLast + spec.tile_width - 1) / spec.tile_width * spec.tile_width, spec.width);
+    }
+
+    // Only the rows contributing to one output row are held in memory at a time (whole rows of tiles for tiled files)
+    const std::size_t rowSize = static_cast<std::size_t>(xReadEnd - xRead) * static_cast<std::size_t>(nbChannels);
+    const int bandHeight = tiled ? (factor + spec.tile_height - 1) / spec.tile_height * spec.tile_height + spec.tile_height : factor;
+    std::vector<float> rows(rowSize * static_cast<std::size_t>(bandHeight));
+    std::vector<uint8_t> rawRows(useTable ? rows.size() : 0);
+    std::vector<float> sums(static_cast<std::size_t>(width) * 4);
+
+    // Rows currently held in memory
+    int bandBegin = 0;
+    int bandEnd = 0;
+
+    img.resize(width, height);
+
+    for (int y = 0; y < height; ++y)
+    {
+        if (cancel && cancel->load(std::memory_order_relaxed))
+        {
+            return true;
+        }
+
+        const int yBegin = std::min((yOffset + y) * factor, spec.height - 1);
+        const int yEnd = std::min(yBegin + factor, spec.height);
+
+        if (yBegin < bandBegin || yEnd > bandEnd)
+        {
+            // Read scanlines, or the rows of tiles covering them
+            bandBegin = tiled ? yBegin / spec.tile_height * spec.tile_height : yBegin;
+            bandEnd = tiled ? std::min((yEnd + spec.tile_height - 1) / spec.tile_height * spec.tile_height, spec.height) : yEnd;
+            const oiio::TypeDesc format = useTable ? oiio::TypeDesc::UINT8 : oiio::TypeDesc::FLOAT;
+            void* data = useTable ? static_cast<void*>(rawRows.data()) : static_cast<void*>(rows.data());
+
+            bool success;
+            if (tiled)
+            {
+                success = input->read_tiles(0,
+                                            level,
+                                            spec.x + xRead,
+                                            spec.x + xReadEnd,
+                                            spec.y + bandBegin,
+                                            spec.y + bandEnd,
+                                            spec.z,
+                                            spec.z + 1,
+                                            0,
+                                            nbChannels,
+                                            format,
+                                            data);
+            }
+            else
+            {
+                success = input->read_scanlines(0, level, spec.y + bandBegin, spec.y + bandEnd, 0, 0, nbChannels, format, data);
+            }
+            if (!success)
+            {
+                throw std::runtime_error("Failed to read image '" + path + "': " + input->geterror());
+            }
+
+            // Linearize values before filtering, alpha is always linear
+            const std::size_t nbValues = rowSize * static_cast<std::size_t>(bandEnd - bandBegin);
+            if (useTable)
+            {
+                const std::array<float, 256>& table = srgbTable();
+                for (std::size_t i = 0; i < nbValues; ++i)
+                {
+                    const bool isAlpha = static_cast<int>(i % static_cast<std::size_t>(nbChannels)) == alpha;
+                    rows[i] = isAlpha ? static_cast<float>(rawRows[i]) / 255.f : table[rawRows[i]];
+                }
+            }
+            else if (transfer == ETransfer::SRGB)
+            {
+                for (std::size_t i = 0; i < nbValues; ++i)
+                {
+                    const bool isAlpha = static_cast<int>(i % static_cast<std::size_t>(nbChannels)) == alpha;
+                    rows[i] = isAlpha ? rows[i] : srgbToLinear(rows[i]);
+                }
+            }
+        }
+
+        // Box filter
+        std::fill(sums.begin(), sums.end(), 0.f);
+        for (int row = yBegin; row < yEnd; ++row)
+        {
+            const float* values = rows.data() + static_cast<std::size_t>(row - bandBegin) * rowSize;
+            for (int x = 0; x < width; ++x)
+            {
+                const int xBegin = std::min((xOffset + x) * factor, spec.width - 1);
+                const int xEnd = std::min(xBegin + factor, spec.width);
+                float* sum = sums.data() + static_cast<std::size_t>(x) * 4;
+                for (int i = xBegin; i < xEnd; ++i)
+                {
+                    const float* pixel = values + static_cast<std::size_t>(i - xRead) * static_cast<std::size_t>(nbChannels);
+                    sum[0] += pixel[0];
+                    sum[1] += pixel[green];
+                    sum[2] += pixel[blue];
+                    sum[3] += (alpha >= 0) ? pixel[alpha] : 1.f;
+                }
+            }
+        }
+
+        for (int x = 0; x < width; ++x)
+        {
+            const int xBegin = std::min((xOffset + x) * factor, spec.width - 1);
+            const int xEnd = std::min(xBegin + factor, spec.width);
+            const float weight = 1.f / static_cast<float>((xEnd - xBegin) * (yEnd - yBegin));
+            const float* sum = sums.data() + static_cast<std::size_t>(x) * 4;
+            img(y, x) = aliceVision::image::RGBAfColor(sum[0] * weight, sum[1] * weight, sum[2] * weight, sum[3] * weight);
+        }
+    }
+
+    return true;
+}
+
+}  // namespace
+
+uint64_t decodeImage(const std::string& path,
+                     int downscale,
+                     aliceVision::image::Image<aliceVision::image::RGBAfColor>& img,
+                     const std::atomic_bool* cancel)
+{
+    // Pixels are filtered straight from scanlines into the output image
+    // At full resolution, scanlines are only streamed when decoding can be cancelled
+    if ((downscale > 1 || cancel) && decodeReduced(path, downscale, Region(), img, cancel))
+    {
+        return 0;
+    }
+
+    // Read full resolution image
+    // AliceVision decodes into an intermediate buffer, then copies pixels into the output image
+    aliceVision::image::readImage(path, img, aliceVision::image::EImageColorSpace::LINEAR);
+    uint64_t bytesCopied = imageSize(img);
+
+    // Apply downscale
+    if (downscale > 1)
+    {
+        aliceVision::imageAlgo::resizeImage(downscale, img);
+        bytesCopied += imageSize(img);
+    }
+
+    return bytesCopied;
+}
+
+bool canDecodeRegion(const std::string& path)
+{
+    ETransfer transfer;
+    std::unique_ptr<oiio::ImageInput> input = openReducible(path, transfer);
+    return input && input->spec().tile_width > 0 && input->spec().tile_height > 0;
+}
+
+uint64_t decodeRegion(const std::string& path, int downscale, const Region& region, aliceVision::image::Image<aliceVision::image::RGBAfColor>& img)
+{
+    // Only the tiles or scanlines covering the region are read
+    if (decodeReduced(path, downscale, region, img))
+    {
+        return 0;
+    }
+
+    // Read the whole image, then crop the region
+    aliceVision::image::Image<aliceVision::image::RGBAfColor> full;
+    uint64_t bytesCopied = decodeImage(path, downscale, full);
+
+    const int xOffset = std::clamp(region.x, 0, full.Width());
+    const int yOffset = std::clamp(region.y, 0, full.Height());
+    const int width = std::clamp(region.width, 0, full.Width() - xOffset);
+    const int height = std::clamp(region.height, 0, full.Height() - yOffset);
+
+    img.resize(width, height);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            img(y, x) = full(yOffset + y, xOffset + x);
+        }
+    }
+    bytesCopied += imageSize(img);
+
+    return bytesCopied;
+}
+
+}  // namespace imgserve
+}  // namespace qtAliceVision
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <aliceVision/image/all.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+namespace qtAliceVision {
+namespace imgserve {
+
+/**
+ * @brief Rectangular region of an image, in pixels. The default region covers the whole image.
+ */
+struct Region
+{
+    int x = 0;
+    int y = 0;
+    int width = std::numeric_limits<int>::max();
+    int height = std::numeric_limits<int>::max();
+};
+
+/**
+ * @brief Read an image from disk in linear color space, at a reduced resolution.
+ *
+ * The output image has the same dimensions as a full resolution read followed by imageAlgo::resizeImage,
+ * but the full resolution image is never held in memory when it can be avoided:
+ *  - if the file contains MIP levels (e.g. mipmapped EXR or tiled TIFF), the closest level is read,
+ *  - otherwise the file is read scanline by scanline and box-filtered on the fly.
+ * Files in other formats or color spaces (e.g. RAW files) are read at full resolution with AliceVision, then resized.
+ *
+ * Decoding can be cancelled between scanlines, the streaming read is then also used at full resolution.
+ * Files read with AliceVision cannot be cancelled until they are fully decoded.
+ *
+ * @param[in] path image filepath
+ * @param[in] downscale downscale factor
+ * @param[out] img decoded image, incomplete if decoding has been cancelled
+ * @param[in] cancel flag stopping decoding when set (may be null)
+ * @return the number of bytes copied in memory after decoding (e.g. by resizing)
+ * @throw std::runtime_error if the image cannot be read from disk
+ */
+uint64_t decodeImage(const std::string& path,
+                     int downscale,
+                     aliceVision::image::Image<aliceVision::image::RGBAfColor>& img,
+                     const std::atomic_bool* cancel = nullptr);
+
+/**
+ * @brief Check if regions of an image can be read without reading the whole image, i.e. if the file is tiled
+ *        and in a format and color space read without AliceVision.
+ * @param[in] path image filepath
+ * @return false if the file cannot be opened
+ */
+bool canDecodeRegion(const std::string& path);
+
+/**
+ * @brief Read a region of an image from disk in linear color space, at a reduced resolution.
+ *
+ * Only the tiles (or the full width scanlines in untiled files) covering the region are read and filtered,
+ * at the closest MIP level when the file contains some.
+ * Files in other formats or color spaces are read entirely, then cropped: check canDecodeRegion before reading many regions.
+ *
+ * @param[in] path image filepath
+ * @param[in] downscale downscale factor (1 for full resolution)
+ * @param[in] region region to read, in downscaled image coordinates (clamped to the image)
+ * @param[out] img decoded region
+ * @return the number of bytes copied in memory after decoding
+ * @throw std::runtime_error if the image cannot be read from disk
+ */
+uint64_t decodeRegion(const std::string& path, int downscale, const Region& region, aliceVision::image::Image<aliceVision::image::RGBAfColor>& img);
+
+}  // namespace imgserve
+}  // namespace qtAliceVision
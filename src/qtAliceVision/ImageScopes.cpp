@@ -0,0 +1,209 @@
+#include "ImageScopes.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace qtAliceVision {
+
+namespace {
+
+/// Luma coefficients (Rec. 709).
+constexpr float lumaR = 0.2126f;
+constexpr float lumaG = 0.7152f;
+constexpr float lumaB = 0.0722f;
+
+/// Maximum number of pixels analyzed.
+constexpr int64_t maxSamples = 1 << 20;
+
+/// Normalize values so that the highest one is 1.
+void normalize(std::vector<float>& values)
+{
+    const float maxValue = *std::max_element(values.begin(), values.end());
+    if (maxValue <= 0.f)
+    {
+        return;
+    }
+    for (float& value : values)
+    {
+        value /= maxValue;
+    }
+}
+
+/// Number of intervals of the display encoding table, over gained values in [0, 1].
+constexpr int encodeTableSize = 4096;
+
+/**
+ * @brief Display encoding, identical to the default display transform of the image shader,
+ *        tabulated over gained values in [0, 1] to avoid a call to std::pow per channel and per sample.
+ */
+class DisplayEncoder
+{
+  public:
+    DisplayEncoder(float scale, float gamma)
+      : _scale(scale)
+    {
+        const double exponent = 1.0 / (static_cast<double>(gamma) * 2.2);
+        for (int i = 0; i <= encodeTableSize; ++i)
+        {
+            _table[static_cast<std::size_t>(i)] = static_cast<float>(std::pow(static_cast<double>(i) / encodeTableSize, exponent));
+        }
+    }
+
+    /// Encode a scene-linear value, linearly interpolating the table. Invalid values (NaN, infinities) are encoded as 0 or 1.
+    float operator()(float v) const
+    {
+        const float x = std::min(std::max(0.f, v * _scale), 1.f) * static_cast<float>(encodeTableSize);
+        const int i = std::min(static_cast<int>(x), encodeTableSize - 1);
+        const float t = x - static_cast<float>(i);
+        const float low = _table[static_cast<std::size_t>(i)];
+        return low + t * (_table[static_cast<std::size_t>(i + 1)] - low);
+    }
+
+  private:
+    float _scale;
+    std::array<float, encodeTableSize + 1> _table;
+};
+
+/**
+ * @brief Accumulate scopes: channel ranges over all pixels, histograms and waveform over a regular subset of pixels.
+ * @param[in] img image providing Width(), Height() and RGBA pixels through operator()(y, x)
+ */
+template<typename ImageT>
+void accumulate(const ImageT& img, float scale, float gamma, ImageScopes& scopes)
+{
+    const int width = img.Width();
+    const int height = img.Height();
+
+    if (width <= 0 || height <= 0)
+    {
+        return;
+    }
+
+    // Channel ranges over all pixels, so that isolated extreme values are never missed
+    // Sums are accumulated per row in single precision, then over rows in double precision
+    std::array<float, 4> minimum;
+    std::array<float, 4> maximum;
+    std::array<double, 4> sum = {0.0, 0.0, 0.0, 0.0};
+    minimum.fill(std::numeric_limits<float>::max());
+    maximum.fill(std::numeric_limits<float>::lowest());
+
+    for (int y = 0; y < height; ++y)
+    {
+        std::array<float, 4> rowSum = {0.f, 0.f, 0.f, 0.f};
+        for (int x = 0; x < width; ++x)
+        {
+            const aliceVision::image::RGBAfColor pixel = img(y, x);
+            const std::array<float, 4> values = {pixel.r(), pixel.g(), pixel.b(), pixel.a()};
+            for (std::size_t c = 0; c < values.size(); ++c)
+            {
+                minimum[c] = std::min(minimum[c], values[c]);
+                maximum[c] = std::max(maximum[c], values[c]);
+                rowSum[c] += values[c];
+            }
+        }
+        for (std::size_t c = 0; c < sum.size(); ++c)
+        {
+            sum[c] += static_cast<double>(rowSum[c]);
+        }
+    }
+
+    const double count = static_cast<double>(width) * static_cast<double>(height);
+    scopes.minimum = QVector4D(minimum[0], minimum[1], minimum[2], minimum[3]);
+    scopes.maximum = QVector4D(maximum[0], maximum[1], maximum[2], maximum[3]);
+    scopes.average = QVector4D(static_cast<float>(sum[0] / count),
+                               static_cast<float>(sum[1] / count),
+                               static_cast<float>(sum[2] / count),
+                               static_cast<float>(sum[3] / count));
+
+    // Histograms and waveform on pixels sampled on a regular grid
+    const int64_t nbPixels = static_cast<int64_t>(width) * static_cast<int64_t>(height);
+    const int step = std::max(1, static_cast<int>(std::ceil(std::sqrt(static_cast<double>(nbPixels) / static_cast<double>(maxSamples)))));
+
+    const DisplayEncoder encode(scale, gamma);
+    auto bin = [](float v, int nbBins) { return std::min(static_cast<int>(v * static_cast<float>(nbBins)), nbBins - 1); };
+
+    for (int y = 0; y < height; y += step)
+    {
+        for (int x = 0; x < width; x += step)
+        {
+            const aliceVision::image::RGBAfColor pixel = img(y, x);
+
+            const float r = encode(pixel.r());
+            const float g = encode(pixel.g());
+            const float b = encode(pixel.b());
+            const float luma = lumaR * r + lumaG * g + lumaB * b;
+
+            scopes.histograms[0][static_cast<std::size_t>(bin(r, ImageScopes::histogramBins))] += 1.f;
+            scopes.histograms[1][static_cast<std::size_t>(bin(g, ImageScopes::histogramBins))] += 1.f;
+            scopes.histograms[2][static_cast<std::size_t>(bin(b, ImageScopes::histogramBins))] += 1.f;
+            scopes.histograms[3][static_cast<std::size_t>(bin(luma, ImageScopes::histogramBins))] += 1.f;
+
+            const int column = static_cast<int>(static_cast<int64_t>(x) * ImageScopes::waveformWidth / width);
+            const int row = ImageScopes::waveformHeight - 1 - bin(luma, ImageScopes::waveformHeight);
+            scopes.waveform[static_cast<std::size_t>(row * ImageScopes::waveformWidth + column)] += 1.f;
+        }
+    }
+}
+
+}  // namespace
+
+ImageScopes ImageScopes::compute(const std::shared_ptr<FloatImage>& img, const std::shared_ptr<HalfImage>& halfImg, float scale, float gamma)
+{
+    ImageScopes scopes;
+    for (std::vector<float>& histogram : scopes.histograms)
+    {
+        histogram.assign(histogramBins, 0.f);
+    }
+    scopes.waveform.assign(static_cast<std::size_t>(waveformWidth * waveformHeight), 0.f);
+
+    if (halfImg)
+    {
+        accumulate(*halfImg, scale, gamma, scopes);
+    }
+    else if (img)
+    {
+        accumulate(*img, scale, gamma, scopes);
+    }
+
+    for (std::vector<float>& histogram : scopes.histograms)
+    {
+        normalize(histogram);
+    }
+
+    // Waveform densities are normalized per column, so that sparse columns remain visible
+    for (int x = 0; x < waveformWidth; ++x)
+    {
+        float maxValue = 0.f;
+        for (int y = 0; y < waveformHeight; ++y)
+        {
+            maxValue = std::max(maxValue, scopes.waveform[static_cast<std::size_t>(y * waveformWidth + x)]);
+        }
+        for (int y = 0; maxValue > 0.f && y < waveformHeight; ++y)
+        {
+            scopes.waveform[static_cast<std::size_t>(y * waveformWidth + x)] /= maxValue;
+        }
+    }
+
+    return scopes;
+}
+
+ScopesRunnable::ScopesRunnable(const std::shared_ptr<FloatImage>& img, const std::shared_ptr<HalfImage>& halfImg, float scale, float gamma)
+  : _img(img),
+    _halfImg(halfImg),
+    _scale(scale),
+    _gamma(gamma)
+{}
+
+ScopesRunnable::~ScopesRunnable() {}
+
+void ScopesRunnable::run()
+{
+    // Images are never modified once loaded: they can be read while displayed
+    Q_EMIT done(ImageScopes::compute(_img, _halfImg, _scale, _gamma));
+}
+
+}  // namespace qtAliceVision
+
+#include "ImageScopes.moc"
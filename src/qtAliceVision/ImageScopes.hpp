@@ -0,0 +1,91 @@
+#pragma once
+
+#include "FloatTexture.hpp"
+#include "HalfImage.hpp"
+
+#include <QMetaType>
+#include <QObject>
+#include <QRunnable>
+#include <QVector4D>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace qtAliceVision {
+
+/**
+ * @brief Image statistics displayed in scopes: per-channel histograms, luma waveform and channel ranges.
+ *
+ * Histograms and waveform are computed on display values (gain, exposure and gamma applied, then sRGB-like encoding),
+ * so that they match the displayed image when no lookup table is used.
+ * Channel ranges are computed on scene-linear values, as stored in the image, over all pixels.
+ */
+struct ImageScopes
+{
+    /// Number of bins of histograms, over display values in [0, 1].
+    static constexpr int histogramBins = 256;
+
+    /// Dimensions of the waveform: one column per range of image columns, one row per range of luma values.
+    static constexpr int waveformWidth = 256;
+    static constexpr int waveformHeight = 128;
+
+    /// Histograms of red, green, blue and luma values, normalized so that the highest bin is 1.
+    std::array<std::vector<float>, 4> histograms;
+
+    /// Density of luma values per image column, row by row from the highest luma value, normalized in [0, 1].
+    std::vector<float> waveform;
+
+    /// Minimum, maximum and average RGBA values, over all pixels.
+    QVector4D minimum;
+    QVector4D maximum;
+    QVector4D average;
+
+    /**
+     * @brief Compute the scopes of an image.
+     *        Histograms and waveform are computed on a regular subset of at most about one million pixels.
+     * @param[in] img image to analyze (float or half float precision, the other being null)
+     * @param[in] halfImg image to analyze (float or half float precision, the other being null)
+     * @param[in] scale gain applied to values before display (including exposure)
+     * @param[in] gamma gamma applied to values before display
+     */
+    static ImageScopes compute(const std::shared_ptr<FloatImage>& img, const std::shared_ptr<HalfImage>& halfImg, float scale, float gamma);
+};
+
+/**
+ * @brief Utility class for computing image scopes asynchronously.
+ */
+class ScopesRunnable : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+  public:
+    /**
+     * @param[in] img image to analyze (float or half float precision, the other being null)
+     * @param[in] halfImg image to analyze (float or half float precision, the other being null)
+     * @param[in] scale gain applied to values before display (including exposure)
+     * @param[in] gamma gamma applied to values before display
+     */
+    ScopesRunnable(const std::shared_ptr<FloatImage>& img, const std::shared_ptr<HalfImage>& halfImg, float scale, float gamma);
+
+    ~ScopesRunnable() override;
+
+    /// Main method for computing scopes in a worker thread.
+    Q_SLOT void run() override;
+
+    /**
+     * @brief Signal emitted when scopes have been computed.
+     * @param[in] scopes computed scopes
+     */
+    Q_SIGNAL void done(ImageScopes scopes);
+
+  private:
+    std::shared_ptr<FloatImage> _img;
+    std::shared_ptr<HalfImage> _halfImg;
+    float _scale;
+    float _gamma;
+};
+
+}  // namespace qtAliceVision
+
+Q_DECLARE_METATYPE(qtAliceVision::ImageScopes)
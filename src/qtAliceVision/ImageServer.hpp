@@ -1,5 +1,7 @@
 #pragma once
 
+#include "HalfImage.hpp"
+
 #include <aliceVision/image/all.hpp>
 
 #include <QSize>
@@ -7,6 +9,7 @@
 #include <QMap>
 #include <QMetaType>
 
+#include <cstdint>
 #include <string>
 #include <memory>
 
@@ -21,6 +24,11 @@ struct RequestData
     std::string path;
 
     int downscale = 1;
+
+    /// Maximum width and height of the returned image, 0 if unbounded (larger images are downscaled further when loaded).
+    int maxSize = 0;
+
+    bool operator==(const RequestData& other) const { return path == other.path && downscale == other.downscale && maxSize == other.maxSize; }
 };
 
 /**
@@ -30,6 +38,15 @@ struct ResponseData
 {
     std::shared_ptr<aliceVision::image::Image<aliceVision::image::RGBAfColor>> img;
 
+    /// Image stored in half float precision, set instead of img by servers using half float storage.
+    std::shared_ptr<HalfImage> halfImg;
+
+    /// The image is a low resolution placeholder, the requested image is still being loaded.
+    bool proxy = false;
+
+    /// Bytes copied in memory to produce the image after decoding (resampling, conversions).
+    uint64_t bytesCopied = 0;
+
     QSize dim;
 
     QVariantMap metadata;
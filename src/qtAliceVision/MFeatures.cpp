@@ -1,7 +1,7 @@
 #include "MFeatures.hpp"
+#include "IOScheduler.hpp"
 
 #include <QDebug>
-#include <QThreadPool>
 #include <QFileInfo>
 #include <QMap>
 #include <QString>
@@ -132,7 +132,7 @@ void MFeatures::load()
 
     connect(ioRunnable, &FeaturesIORunnable::resultReady, this, &MFeatures::onFeaturesReady);
 
-    QThreadPool::globalInstance()->start(ioRunnable);
+    IOScheduler::instance().start(IOScheduler::EIOClass::Background, ioRunnable);
 }
 
 void MFeatures::onFeaturesReady(FeaturesPerViewPerDesc* featuresPerViewPerDesc)
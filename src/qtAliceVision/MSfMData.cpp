@@ -1,8 +1,8 @@
 #include "MSfMData.hpp"
+#include "IOScheduler.hpp"
 
 #include <QDebug>
 #include <QFileInfo>
-#include <QThreadPool>
 
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
 
@@ -66,7 +66,7 @@ void MSfMData::load()
     // load features from file in a seperate thread
     SfmDataIORunnable* ioRunnable = new SfmDataIORunnable(_sfmDataPath);
     connect(ioRunnable, &SfmDataIORunnable::resultReady, this, &MSfMData::onSfmDataReady);
-    QThreadPool::globalInstance()->start(ioRunnable);
+    IOScheduler::instance().start(IOScheduler::EIOClass::Background, ioRunnable);
 }
 
 QString MSfMData::getUrlFromViewId(int viewId)
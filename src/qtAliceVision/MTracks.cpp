@@ -1,4 +1,5 @@
 #include "MTracks.hpp"
+#include "IOScheduler.hpp"
 
 #include <aliceVision/matching/io.hpp>
 #include <aliceVision/track/TracksBuilder.hpp>
@@ -6,7 +7,6 @@
 
 #include <QDebug>
 #include <QFileInfo>
-#include <QThreadPool>
 #include <QString>
 
 namespace qtAliceVision {
@@ -84,7 +84,7 @@ void MTracks::load()
 
     TracksIORunnable* ioRunnable = new TracksIORunnable(folders);
     connect(ioRunnable, &TracksIORunnable::resultReady, this, &MTracks::onReady);
-    QThreadPool::globalInstance()->start(ioRunnable);
+    IOScheduler::instance().start(IOScheduler::EIOClass::Background, ioRunnable);
 }
 
 void MTracks::onReady(aliceVision::track::TracksMap* tracks, aliceVision::track::TracksPerView* tracksPerView)
@@ -0,0 +1,236 @@
+#include "MetadataIndex.hpp"
+
+#include <aliceVision/image/io.hpp>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <iostream>
+
+namespace qtAliceVision {
+namespace imgserve {
+
+namespace {
+
+/// Index file header, to detect foreign or outdated files.
+constexpr quint32 indexMagic = 0x51415649;  // "QAVI"
+constexpr quint32 indexVersion = 1;
+
+}  // namespace
+
+MetadataIndex& MetadataIndex::instance()
+{
+    static MetadataIndex index;
+    return index;
+}
+
+MetadataIndex::MetadataIndex()
+{
+    const QString cacheRoot = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+    if (!cacheRoot.isEmpty())
+    {
+        _cacheDir = cacheRoot + "/qtAliceVision/metadata";
+        if (!QDir().mkpath(_cacheDir))
+        {
+            _cacheDir.clear();
+        }
+    }
+}
+
+MetadataIndex::~MetadataIndex() { flush(); }
+
+void MetadataIndex::read(const std::string& path, QSize& dim, QVariantMap& metadata)
+{
+    if (lookup(path, dim, metadata))
+    {
+        return;
+    }
+
+    // Retrieve metadata from disk
+    int width, height;
+    auto oiioMetadata = aliceVision::image::readImageMetadata(path, width, height);
+
+    // Store original image dimensions
+    dim = QSize(width, height);
+
+    // Copy metadata into a QVariantMap
+    metadata.clear();
+    for (const auto& item : oiioMetadata)
+    {
+        metadata[QString::fromStdString(item.name().string())] = QString::fromStdString(item.get_string());
+    }
+
+    store(path, dim, metadata);
+}
+
+bool MetadataIndex::lookup(const std::string& path, QSize& dim, QVariantMap& metadata)
+{
+    const QFileInfo fileInfo(QString::fromStdString(path));
+    if (!fileInfo.exists())
+    {
+        return false;
+    }
+
+    QMutexLocker lock(&_mutex);
+
+    const Folder& folder = getFolder(fileInfo.absolutePath());
+    const auto it = folder.entries.constFind(fileInfo.fileName());
+    if (it == folder.entries.constEnd())
+    {
+        return false;
+    }
+
+    // Make sure the file has not been modified since it was indexed
+    const Entry& entry = it.value();
+    if (entry.mtime != fileInfo.lastModified().toMSecsSinceEpoch() || entry.size != fileInfo.size())
+    {
+        return false;
+    }
+
+    dim = entry.dim;
+    metadata = entry.metadata;
+    return true;
+}
+
+void MetadataIndex::store(const std::string& path, const QSize& dim, const QVariantMap& metadata)
+{
+    const QFileInfo fileInfo(QString::fromStdString(path));
+    if (!fileInfo.exists())
+    {
+        return;
+    }
+
+    Entry entry;
+    entry.mtime = fileInfo.lastModified().toMSecsSinceEpoch();
+    entry.size = fileInfo.size();
+    entry.dim = dim;
+    entry.metadata = metadata;
+
+    QMutexLocker lock(&_mutex);
+
+    Folder& folder = getFolder(fileInfo.absolutePath());
+    folder.entries.insert(fileInfo.fileName(), entry);
+    folder.dirty = true;
+}
+
+void MetadataIndex::flush()
+{
+    // Writes are serialized, so that an older snapshot never replaces a newer index file
+    QMutexLocker flushLock(&_flushMutex);
+
+    // Snapshot modified folders (entries are implicitly shared), files are written without blocking lookups
+    QHash<QString, QHash<QString, Entry>> snapshots;
+    {
+        QMutexLocker lock(&_mutex);
+        if (_cacheDir.isEmpty())
+        {
+            return;
+        }
+
+        for (auto it = _folders.begin(); it != _folders.end(); ++it)
+        {
+            if (it.value().dirty)
+            {
+                snapshots.insert(it.key(), it.value().entries);
+                it.value().dirty = false;
+            }
+        }
+    }
+
+    for (auto it = snapshots.constBegin(); it != snapshots.constEnd(); ++it)
+    {
+        const QHash<QString, Entry>& entries = it.value();
+
+        // Write to a temporary file first so that concurrent processes never read a partial index
+        QSaveFile file(indexFilepath(it.key()));
+        bool success = file.open(QIODevice::WriteOnly);
+        if (success)
+        {
+            QDataStream stream(&file);
+            stream.setVersion(QDataStream::Qt_5_12);
+            stream << indexMagic << indexVersion << it.key() << static_cast<quint32>(entries.size());
+            for (auto entryIt = entries.constBegin(); entryIt != entries.constEnd(); ++entryIt)
+            {
+                const Entry& entry = entryIt.value();
+                stream << entryIt.key() << entry.mtime << entry.size << entry.dim << entry.metadata;
+            }
+            success = file.commit();
+        }
+
+        if (!success)
+        {
+            std::cerr << "Failed to write metadata index: " << file.fileName().toStdString() << std::endl;
+
+            // Retry at the next flush
+            QMutexLocker lock(&_mutex);
+            _folders[it.key()].dirty = true;
+        }
+    }
+}
+
+MetadataIndex::Folder& MetadataIndex::getFolder(const QString& dirPath)
+{
+    auto it = _folders.find(dirPath);
+    if (it != _folders.end())
+    {
+        return it.value();
+    }
+
+    Folder& folder = _folders[dirPath];
+    if (_cacheDir.isEmpty())
+    {
+        return folder;
+    }
+
+    QFile file(indexFilepath(dirPath));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return folder;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic = 0, version = 0, nbEntries = 0;
+    QString indexedDirPath;
+    stream >> magic >> version >> indexedDirPath >> nbEntries;
+
+    // Ignore outdated files and hash collisions
+    if (magic != indexMagic || version != indexVersion || indexedDirPath != dirPath)
+    {
+        return folder;
+    }
+
+    folder.entries.reserve(static_cast<int>(nbEntries));
+    for (quint32 i = 0; i < nbEntries && stream.status() == QDataStream::Ok; ++i)
+    {
+        QString filename;
+        Entry entry;
+        stream >> filename >> entry.mtime >> entry.size >> entry.dim >> entry.metadata;
+        folder.entries.insert(filename, entry);
+    }
+
+    // Discard a truncated or corrupted index
+    if (stream.status() != QDataStream::Ok)
+    {
+        folder.entries.clear();
+    }
+
+    return folder;
+}
+
+QString MetadataIndex::indexFilepath(const QString& dirPath) const
+{
+    const QByteArray hash = QCryptographicHash::hash(dirPath.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return _cacheDir + "/" + QString::fromLatin1(hash) + ".idx";
+}
+
+}  // namespace imgserve
+}  // namespace qtAliceVision
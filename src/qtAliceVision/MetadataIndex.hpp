@@ -0,0 +1,108 @@
+#pragma once
+
+#include <QSize>
+#include <QVariant>
+#include <QString>
+#include <QHash>
+#include <QMutex>
+
+#include <string>
+
+namespace qtAliceVision {
+namespace imgserve {
+
+/**
+ * @brief Persistent on-disk index of image dimensions and metadata.
+ *
+ * Entries are keyed by filepath and validated against the file's modification time and size,
+ * so that reopening a known image costs a file status query instead of a header read.
+ * The index is split in one compact binary file per image folder, stored in the user cache location.
+ *
+ * The index is shared by all image servers of the process and can be accessed from any thread.
+ */
+class MetadataIndex
+{
+  public:
+    /// Get the process-wide index.
+    static MetadataIndex& instance();
+
+    ~MetadataIndex();
+
+    MetadataIndex(const MetadataIndex&) = delete;
+    MetadataIndex& operator=(const MetadataIndex&) = delete;
+
+    /**
+     * @brief Retrieve the dimensions and metadata of an image, from the index if possible or else from disk.
+     * @param[in] path image filepath
+     * @param[out] dim original image dimensions
+     * @param[out] metadata image metadata
+     * @throw std::runtime_error if the image metadata cannot be read from disk
+     */
+    void read(const std::string& path, QSize& dim, QVariantMap& metadata);
+
+    /**
+     * @brief Look up an image in the index.
+     * @param[in] path image filepath
+     * @param[out] dim original image dimensions
+     * @param[out] metadata image metadata
+     * @return true if the image is indexed and has not been modified since, otherwise false
+     */
+    bool lookup(const std::string& path, QSize& dim, QVariantMap& metadata);
+
+    /**
+     * @brief Add or update an image in the index.
+     * @param[in] path image filepath
+     * @param[in] dim original image dimensions
+     * @param[in] metadata image metadata
+     */
+    void store(const std::string& path, const QSize& dim, const QVariantMap& metadata);
+
+    /**
+     * @brief Write modified index files to disk.
+     * @note called when metadata scans complete and when the index is destroyed, lookups are not blocked while writing
+     */
+    void flush();
+
+  private:
+    MetadataIndex();
+
+    /// Indexed information about an image file.
+    struct Entry
+    {
+        qint64 mtime = 0;
+        qint64 size = 0;
+        QSize dim;
+        QVariantMap metadata;
+    };
+
+    /// Index of the images of a folder, persisted in a single file.
+    struct Folder
+    {
+        QHash<QString, Entry> entries;
+        bool dirty = false;
+    };
+
+    /**
+     * @brief Get the index of a folder, loading it from disk on first access.
+     * @note must be called with the index mutex locked
+     */
+    Folder& getFolder(const QString& dirPath);
+
+    /// Filepath of the index file of a folder.
+    QString indexFilepath(const QString& dirPath) const;
+
+    /// Directory where index files are stored (empty if unavailable).
+    QString _cacheDir;
+
+    /// Indexed folders.
+    QHash<QString, Folder> _folders;
+
+    /// Index mutex.
+    QMutex _mutex;
+
+    /// Mutex serializing index file writes.
+    QMutex _flushMutex;
+};
+
+}  // namespace imgserve
+}  // namespace qtAliceVision
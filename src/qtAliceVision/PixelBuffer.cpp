@@ -0,0 +1,94 @@
+#include "PixelBuffer.hpp"
+
+#include <QFile>
+
+#include <new>
+
+#ifdef _WIN32
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+namespace qtAliceVision {
+
+std::shared_ptr<PixelBuffer> PixelBuffer::allocate(std::size_t size)
+{
+    std::shared_ptr<PixelBuffer> buffer(new PixelBuffer());
+    buffer->_data = static_cast<uint8_t*>(::operator new(size, std::align_val_t(pageSize)));
+    buffer->_size = size;
+    return buffer;
+}
+
+std::shared_ptr<PixelBuffer> PixelBuffer::map(const QString& filepath, qint64 offset, std::size_t size)
+{
+    // Map from the beginning of the file to satisfy mapping offset granularity on all platforms
+    const std::size_t mappingSize = static_cast<std::size_t>(offset) + size;
+
+    // File handles are closed right away: cached images must not exhaust file descriptors
+#ifdef _WIN32
+    HANDLE file = CreateFileW(reinterpret_cast<LPCWSTR>(filepath.utf16()),
+                              GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_DELETE,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return nullptr;
+    }
+    HANDLE fileMapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!fileMapping)
+    {
+        return nullptr;
+    }
+    void* mapping = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, mappingSize);
+    CloseHandle(fileMapping);
+    if (!mapping)
+    {
+        return nullptr;
+    }
+#else
+    const int fd = ::open(QFile::encodeName(filepath).constData(), O_RDONLY);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+    void* mapping = ::mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        return nullptr;
+    }
+#endif
+
+    std::shared_ptr<PixelBuffer> buffer(new PixelBuffer());
+    buffer->_mapping = mapping;
+    buffer->_mappingSize = mappingSize;
+    buffer->_data = static_cast<uint8_t*>(mapping) + offset;
+    buffer->_size = size;
+    return buffer;
+}
+
+PixelBuffer::~PixelBuffer()
+{
+    if (_mapping)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(_mapping);
+#else
+        ::munmap(_mapping, _mappingSize);
+#endif
+    }
+    else if (_data)
+    {
+        ::operator delete(_data, std::align_val_t(pageSize));
+    }
+}
+
+}  // namespace qtAliceVision
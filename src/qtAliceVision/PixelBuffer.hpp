@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QString>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace qtAliceVision {
+
+/**
+ * @brief Memory block holding pixel data, either allocated on page boundaries or mapped from a file.
+ *
+ * Page-aligned memory can be handed to the driver for texture uploads without realignment,
+ * and mapped memory is read directly from the page cache, without copying file content.
+ * Buffers are not copyable: images share them through std::shared_ptr.
+ */
+class PixelBuffer
+{
+  public:
+    /// Alignment of allocated buffers, in bytes.
+    static constexpr std::size_t pageSize = 4096;
+
+    /**
+     * @brief Allocate a page-aligned buffer.
+     * @param[in] size buffer size, in bytes
+     * @throw std::bad_alloc if memory cannot be allocated
+     */
+    static std::shared_ptr<PixelBuffer> allocate(std::size_t size);
+
+    /**
+     * @brief Map a region of a file in read-only memory.
+     * @note the mapping does not keep a file handle open, it remains valid if the file is removed
+     * @param[in] filepath file to map
+     * @param[in] offset offset of the region in the file, in bytes
+     * @param[in] size size of the region, in bytes
+     * @return the mapped buffer, or null if the file cannot be mapped
+     */
+    static std::shared_ptr<PixelBuffer> map(const QString& filepath, qint64 offset, std::size_t size);
+
+    ~PixelBuffer();
+
+    PixelBuffer(const PixelBuffer&) = delete;
+    PixelBuffer& operator=(const PixelBuffer&) = delete;
+
+    /// Buffer content (must not be written to if the buffer is mapped).
+    uint8_t* data() const { return _data; }
+
+    /// Buffer size, in bytes.
+    std::size_t size() const { return _size; }
+
+    /// Check if the buffer is mapped from a file.
+    bool isMapped() const { return _mapping != nullptr; }
+
+  private:
+    PixelBuffer() = default;
+
+    uint8_t* _data = nullptr;
+    std::size_t _size = 0;
+
+    /// Start of the file mapping (from the beginning of the file), null for allocated buffers.
+    void* _mapping = nullptr;
+    std::size_t _mappingSize = 0;
+};
+
+}  // namespace qtAliceVision
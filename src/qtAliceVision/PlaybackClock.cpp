@@ -0,0 +1,146 @@
+#include "PlaybackClock.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace qtAliceVision {
+
+namespace {
+
+/// Window over which the delivered frame rate is measured, in milliseconds.
+constexpr int64_t deliveryWindow = 1000;
+
+}  // namespace
+
+PlaybackClock::PlaybackClock(QObject* parent)
+  : QObject(parent)
+{
+    // Coarse timers may be off by 5% of their interval, i.e. more than a frame period at high rates
+    _timer.setTimerType(Qt::PreciseTimer);
+    connect(&_timer, &QTimer::timeout, this, &PlaybackClock::tick);
+}
+
+PlaybackClock::~PlaybackClock() {}
+
+void PlaybackClock::setFps(double fps)
+{
+    _fps = std::max(1.0, fps);
+    if (isRunning())
+    {
+        restart(_frame, false);
+    }
+}
+
+void PlaybackClock::setRange(int first, int last)
+{
+    _first = std::max(0, first);
+    _last = std::max(_first, last);
+    if (isRunning())
+    {
+        restart(std::clamp(_frame, _first, _last), false);
+    }
+}
+
+void PlaybackClock::start(int frame)
+{
+    _nbDelivered = 0;
+    _nbMissed = 0;
+    _nbLate = 0;
+    _deliveries.clear();
+    _lastStats = 0;
+    _session.start();
+
+    restart((frame < _first || frame > _last) ? _first : frame, true);
+}
+
+void PlaybackClock::stop()
+{
+    if (!isRunning())
+    {
+        return;
+    }
+    _timer.stop();
+    Q_EMIT statsChanged();
+}
+
+void PlaybackClock::reportFrame(bool delivered)
+{
+    if (!delivered)
+    {
+        ++_nbMissed;
+        return;
+    }
+
+    ++_nbDelivered;
+    const int64_t now = _session.elapsed();
+    _deliveries.push_back(now);
+    while (!_deliveries.empty() && now - _deliveries.front() > deliveryWindow)
+    {
+        _deliveries.pop_front();
+    }
+}
+
+double PlaybackClock::getDeliveredFps() const
+{
+    if (!_session.isValid())
+    {
+        return 0.0;
+    }
+
+    // At playback start, the rate is measured over the elapsed time only
+    const int64_t now = _session.elapsed();
+    const auto nbRecent = std::count_if(_deliveries.begin(), _deliveries.end(), [now](int64_t t) { return now - t <= deliveryWindow; });
+    const int64_t window = std::clamp(now, static_cast<int64_t>(1), deliveryWindow);
+    return static_cast<double>(nbRecent) * 1000.0 / static_cast<double>(window);
+}
+
+double PlaybackClock::getHitRatio() const
+{
+    const int nbReported = _nbDelivered + _nbMissed;
+    return (nbReported > 0) ? static_cast<double>(_nbDelivered) / static_cast<double>(nbReported) : 1.0;
+}
+
+void PlaybackClock::tick()
+{
+    // Number of frame periods elapsed since the start of timing
+    const double elapsed = static_cast<double>(_elapsed.nsecsElapsed()) * 1e-9;
+    const int64_t index = static_cast<int64_t>(std::floor(elapsed * _fps));
+
+    if (index > _index)
+    {
+        // Frames whose time has passed while the event loop was busy are skipped
+        _nbLate += static_cast<int>(index - _index - 1);
+        _index = index;
+        _frame = frameAt(index);
+        Q_EMIT frameDue(_frame);
+    }
+
+    const int64_t now = _session.elapsed();
+    if (now - _lastStats >= 1000)
+    {
+        _lastStats = now;
+        Q_EMIT statsChanged();
+    }
+}
+
+void PlaybackClock::restart(int frame, bool due)
+{
+    _startFrame = frame;
+    _frame = frame;
+    _index = due ? -1 : 0;
+    _elapsed.start();
+
+    // Wake up several times per frame period to keep timing error low
+    _timer.start(std::max(1, static_cast<int>(250.0 / _fps)));
+}
+
+int PlaybackClock::frameAt(int64_t index) const
+{
+    const int64_t length = static_cast<int64_t>(_last - _first) + 1;
+    const int64_t offset = (static_cast<int64_t>(_startFrame - _first) + index) % length;
+    return _first + static_cast<int>(offset);
+}
+
+}  // namespace qtAliceVision
+
+#include "PlaybackClock.moc"
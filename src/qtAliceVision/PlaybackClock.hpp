@@ -0,0 +1,138 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+#include <cstdint>
+#include <deque>
+
+namespace qtAliceVision {
+
+/**
+ * @brief Clock pacing the playback of an image sequence at a target frame rate.
+ *
+ * Due frames are derived from the time elapsed since playback started, so that timing does not drift
+ * when the display is late: frames whose time has passed are skipped instead of delaying the next ones.
+ * Frames loop over a range of the sequence.
+ *
+ * The clock also gathers playback statistics: clients report whether each due frame has been displayed
+ * (a cache hit) or skipped (a cache miss).
+ */
+class PlaybackClock : public QObject
+{
+    Q_OBJECT
+
+  public:
+    explicit PlaybackClock(QObject* parent = nullptr);
+
+    ~PlaybackClock() override;
+
+    /**
+     * @brief Set the target frame rate.
+     * @param[in] fps frames per second (at least 1)
+     * @note if the clock is running, playback continues from the current frame at the new rate
+     */
+    void setFps(double fps);
+
+    /// Get the target frame rate, in frames per second.
+    double getFps() const { return _fps; }
+
+    /**
+     * @brief Set the range of frames played in loop.
+     * @param[in] first first frame of the range
+     * @param[in] last last frame of the range (included)
+     */
+    void setRange(int first, int last);
+
+    /**
+     * @brief Start playback, resetting statistics.
+     * @param[in] frame first frame to play, brought back in the loop range if outside
+     */
+    void start(int frame);
+
+    /// Stop playback, statistics are kept until the next start.
+    void stop();
+
+    /// Check if playback is running.
+    bool isRunning() const { return _timer.isActive(); }
+
+    /// Get the last due frame.
+    int getFrame() const { return _frame; }
+
+    /**
+     * @brief Report the outcome of the last due frame.
+     * @param[in] delivered true if the frame has been displayed, false if it has been skipped (e.g. not in cache)
+     */
+    void reportFrame(bool delivered);
+
+    /// Get the rate of displayed frames over the last second, in frames per second.
+    double getDeliveredFps() const;
+
+    /// Get the proportion of due frames that have been displayed, in [0, 1].
+    double getHitRatio() const;
+
+    /// Get the number of displayed frames since playback started.
+    int getDeliveredFrames() const { return _nbDelivered; }
+
+    /// Get the number of frames skipped since playback started, either late or not available.
+    int getDroppedFrames() const { return _nbLate + _nbMissed; }
+
+    /**
+     * @brief Signal emitted when a frame is due for display.
+     * @param[in] frame frame number
+     */
+    Q_SIGNAL void frameDue(int frame);
+
+    /// Signal emitted about once per second during playback, when statistics have been updated.
+    Q_SIGNAL void statsChanged();
+
+  private:
+    /// Timer callback, emitting due frames.
+    void tick();
+
+    /**
+     * @brief Restart timing from a given frame.
+     * @param[in] frame frame displayed at the start of timing
+     * @param[in] due true if the frame is due, false if it has already been displayed
+     */
+    void restart(int frame, bool due);
+
+    /// Get the frame displayed at a given number of frame periods after the start of timing.
+    int frameAt(int64_t index) const;
+
+    /// Timer waking the clock regularly during playback.
+    QTimer _timer;
+
+    /// Time elapsed since the start of timing.
+    QElapsedTimer _elapsed;
+
+    /// Time elapsed since playback started, used for statistics.
+    QElapsedTimer _session;
+
+    double _fps = 24.0;
+    int _first = 0;
+    int _last = 0;
+
+    /// Frame displayed at the start of timing.
+    int _startFrame = 0;
+
+    /// Number of frame periods from the start of timing to the last due frame.
+    int64_t _index = -1;
+
+    /// Last due frame.
+    int _frame = 0;
+
+    /// Frame counts since playback started.
+    int _nbDelivered = 0;
+    int _nbMissed = 0;
+    int _nbLate = 0;
+
+    /// Display times of frames delivered during the last second, in milliseconds since playback started.
+    std::deque<int64_t> _deliveries;
+
+    /// Time of the last statistics update, in milliseconds since playback started.
+    int64_t _lastStats = 0;
+};
+
+}  // namespace qtAliceVision
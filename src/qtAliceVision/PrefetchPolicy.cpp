@@ -0,0 +1,128 @@
+#include "PrefetchPolicy.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace qtAliceVision {
+namespace imgserve {
+
+namespace {
+
+/**
+ * @brief Build a frame interval in the sequence.
+ * @param[in] frame central frame of the interval
+ * @param[in] extent interval half-size
+ * @param[in] nbFrames number of frames in the sequence
+ * @return an interval of size 2*extent that fits in the sequence and contains the given frame
+ */
+std::pair<int, int> buildRegion(int frame, int extent, int nbFrames)
+{
+    // Initialize region equally around central frame
+    int start = frame - extent;
+    int end = frame + extent;
+
+    // Adjust to sequence bounds
+    if (start < 0)
+    {
+        start = 0;
+        end = std::min(nbFrames - 1, 2 * extent);
+    }
+    else if (end >= nbFrames)
+    {
+        end = nbFrames - 1;
+        start = std::max(0, nbFrames - 1 - 2 * extent);
+    }
+
+    return std::make_pair(start, end);
+}
+
+}  // namespace
+
+PrefetchPolicy::PrefetchPolicy() { _timer.start(); }
+
+PrefetchPolicy::~PrefetchPolicy() {}
+
+void PrefetchPolicy::update(int frame)
+{
+    // Clients may request the same frame several times (e.g. on reload)
+    if (frame == _lastFrame)
+    {
+        return;
+    }
+
+    const qint64 time = _timer.elapsed();
+
+    if (_lastFrame >= 0)
+    {
+        // Instant velocity between the last two distinct requests
+        const double dt = static_cast<double>(std::max<qint64>(time - _lastTime, 1)) / 1000.;
+        const double velocity = static_cast<double>(frame - _lastFrame) / dt;
+
+        // Exponential smoothing to filter out jitter in request timing
+        const double alpha = 0.3;
+        _velocity = alpha * velocity + (1. - alpha) * _velocity;
+
+        _direction = frame > _lastFrame ? 1 : -1;
+    }
+
+    _lastFrame = frame;
+    _lastTime = time;
+}
+
+void PrefetchPolicy::inheritTracking(const PrefetchPolicy& other)
+{
+    // Times of requests are relative to the timer
+    _timer = other._timer;
+    _lastFrame = other._lastFrame;
+    _lastTime = other._lastTime;
+    _velocity = other._velocity;
+    _direction = other._direction;
+}
+
+PrefetchOrder SymmetricPrefetchPolicy::order(int reqFrame) const
+{
+    PrefetchOrder prefetchOrder;
+    prefetchOrder.reqFrame = reqFrame;
+    return prefetchOrder;
+}
+
+std::pair<int, int> SymmetricPrefetchPolicy::safeRegion(const std::pair<int, int>& regionCached, int reqFrame, int nbFrames) const
+{
+    // Here we define safe region to cover 80% of cached region
+    // The remaining 20% serves to anticipate prefetching
+    const int extentCached = (regionCached.second - regionCached.first) / 2;
+    const int extentSafe = static_cast<int>(static_cast<double>(extentCached) * 0.8);
+    return buildRegion(reqFrame, extentSafe, nbFrames);
+}
+
+PrefetchOrder DirectionalPrefetchPolicy::order(int reqFrame) const
+{
+    // Frames behind the direction of travel cost between 2 and 4 times more than frames ahead,
+    // depending on how close the request speed is to a typical playback rate
+    const double referenceFps = 24.;
+    const double speed = std::min(std::abs(getVelocity()) / referenceFps, 1.);
+    const double costBehind = 2. + 2. * speed;
+
+    PrefetchOrder prefetchOrder;
+    prefetchOrder.reqFrame = reqFrame;
+    prefetchOrder.costForward = getDirection() > 0 ? 1. : costBehind;
+    prefetchOrder.costBackward = getDirection() > 0 ? costBehind : 1.;
+    return prefetchOrder;
+}
+
+std::pair<int, int> DirectionalPrefetchPolicy::safeRegion(const std::pair<int, int>& regionCached, int reqFrame, int nbFrames) const
+{
+    (void)nbFrames;
+
+    // Keep the last 20% of cached region in the direction of travel to anticipate prefetching,
+    // frames behind do not need anticipation as they are not likely to be requested soon
+    const int margin = static_cast<int>(static_cast<double>(regionCached.second - regionCached.first) * 0.2);
+    if (getDirection() > 0)
+    {
+        return std::make_pair(regionCached.first, std::max(reqFrame, regionCached.second - margin));
+    }
+    return std::make_pair(std::min(reqFrame, regionCached.first + margin), regionCached.second);
+}
+
+}  // namespace imgserve
+}  // namespace qtAliceVision
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <QElapsedTimer>
+
+#include <utility>
+
+namespace qtAliceVision {
+namespace imgserve {
+
+/**
+ * @brief Immutable description of the order in which frames are prefetched around a requested frame.
+ *
+ * Frames are loaded by increasing weighted distance to the requested frame,
+ * where frames ahead and behind (in the direction of travel) can be given different costs.
+ * A snapshot is handed to the prefetching workers so that they never access the policy itself.
+ */
+struct PrefetchOrder
+{
+    /// Initially requested frame, used as central point for loading order.
+    int reqFrame = 0;
+
+    /// Cost of one frame after the requested frame.
+    double costForward = 1.;
+
+    /// Cost of one frame before the requested frame.
+    double costBackward = 1.;
+
+    /// Weighted distance of a frame to the requested frame.
+    double distance(int frame) const
+    {
+        return frame >= reqFrame ? costForward * static_cast<double>(frame - reqFrame) : costBackward * static_cast<double>(reqFrame - frame);
+    }
+};
+
+/**
+ * @brief Strategy deciding which frames should be prefetched around a request and when to prefetch again.
+ *
+ * The policy is fed with every request made to the SequenceCache
+ * and keeps track of the scrub direction and speed from successive requests.
+ */
+class PrefetchPolicy
+{
+  public:
+    PrefetchPolicy();
+
+    virtual ~PrefetchPolicy();
+
+    /**
+     * @brief Notify the policy that a frame has been requested.
+     * @param[in] frame requested frame
+     */
+    void update(int frame);
+
+    /**
+     * @brief Continue tracking requests from the state of another policy, e.g. when switching between playback and scrubbing.
+     * @param[in] other policy replaced by this one
+     */
+    void inheritTracking(const PrefetchPolicy& other);
+
+    /// Get the smoothed request velocity, in frames per second (negative when going backward).
+    double getVelocity() const { return _velocity; }
+
+    /// Get the last direction of travel (1 forward, -1 backward).
+    int getDirection() const { return _direction; }
+
+    /**
+     * @brief Build the loading order of a prefetching job.
+     * @param[in] reqFrame initially requested frame
+     * @return a snapshot of the loading order
+     */
+    virtual PrefetchOrder order(int reqFrame) const = 0;
+
+    /**
+     * @brief Compute the frame interval in which requests do not trigger a new prefetching job.
+     * @param[in] regionCached interval of cached frames containing the requested frame
+     * @param[in] reqFrame frame initially requested when the prefetching job was started
+     * @param[in] nbFrames number of frames in the sequence
+     * @return the safe frame interval
+     */
+    virtual std::pair<int, int> safeRegion(const std::pair<int, int>& regionCached, int reqFrame, int nbFrames) const = 0;
+
+  private:
+    /// Timer used to measure request velocity.
+    QElapsedTimer _timer;
+
+    /// Last requested frame.
+    int _lastFrame = -1;
+
+    /// Time of last request, in milliseconds.
+    qint64 _lastTime = 0;
+
+    /// Smoothed request velocity, in frames per second.
+    double _velocity = 0.;
+
+    /// Last direction of travel.
+    int _direction = 1;
+};
+
+/**
+ * @brief Prefetch policy loading frames equally on both sides of the requested frame.
+ *
+ * Suited for interactive scrubbing, where the next request may be in either direction.
+ */
+class SymmetricPrefetchPolicy : public PrefetchPolicy
+{
+  public:
+    PrefetchOrder order(int reqFrame) const override;
+
+    std::pair<int, int> safeRegion(const std::pair<int, int>& regionCached, int reqFrame, int nbFrames) const override;
+};
+
+/**
+ * @brief Prefetch policy favoring frames ahead of the requested frame in the direction of travel.
+ *
+ * Suited for playback: the faster the requests go, the more the cache budget goes to upcoming frames.
+ */
+class DirectionalPrefetchPolicy : public PrefetchPolicy
+{
+  public:
+    PrefetchOrder order(int reqFrame) const override;
+
+    std::pair<int, int> safeRegion(const std::pair<int, int>& regionCached, int reqFrame, int nbFrames) const override;
+};
+
+}  // namespace imgserve
+}  // namespace qtAliceVision
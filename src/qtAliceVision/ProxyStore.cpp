@@ -0,0 +1,211 @@
+#include "ProxyStore.hpp"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+namespace qtAliceVision {
+namespace imgserve {
+
+namespace {
+
+/// Proxy file header, followed by raw half float RGBA data starting on the next page boundary.
+struct ProxyHeader
+{
+    quint32 magic;
+    quint32 version;
+    qint32 width;
+    qint32 height;
+};
+
+/// Proxy file header values, to detect foreign or outdated files.
+constexpr quint32 proxyMagic = 0x51415650;  // "QAVP"
+constexpr quint32 proxyVersion = 2;
+
+/// Offset of pixel data in proxy files, so that mapped pixel data is page-aligned.
+constexpr qint64 dataOffset = static_cast<qint64>(PixelBuffer::pageSize);
+
+}  // namespace
+
+ProxyStore& ProxyStore::instance()
+{
+    static ProxyStore store;
+    return store;
+}
+
+ProxyStore::ProxyStore()
+  : _capacity(10ull * 1024 * 1024 * 1024)
+{
+    const QString cacheRoot = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+    if (cacheRoot.isEmpty())
+    {
+        return;
+    }
+
+    _cacheDir = cacheRoot + "/qtAliceVision/proxies";
+    if (!QDir().mkpath(_cacheDir))
+    {
+        _cacheDir.clear();
+        return;
+    }
+
+    // Retrieve size of proxies stored by previous sessions
+    const QFileInfoList files = QDir(_cacheDir).entryInfoList({"*.qavp"}, QDir::Files);
+    for (const QFileInfo& fileInfo : files)
+    {
+        _size += static_cast<uint64_t>(fileInfo.size());
+    }
+}
+
+bool ProxyStore::read(const std::string& path, int downscale, HalfImage& img)
+{
+    if (_cacheDir.isEmpty())
+    {
+        return false;
+    }
+
+    const QString filepath = proxyFilepath(QFileInfo(QString::fromStdString(path)), downscale);
+    if (filepath.isEmpty())
+    {
+        return false;
+    }
+
+    QFile file(filepath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    ProxyHeader header;
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) != static_cast<qint64>(sizeof(header)))
+    {
+        return false;
+    }
+
+    // Ignore outdated or truncated files
+    const qint64 dataSize = static_cast<qint64>(header.width) * header.height * 4 * 2;
+    if (header.magic != proxyMagic || header.version != proxyVersion || header.width <= 0 || header.height <= 0 ||
+        file.size() != dataOffset + dataSize)
+    {
+        return false;
+    }
+
+    // Map pixel data: the image is read from the page cache on access, without copying it
+    std::shared_ptr<PixelBuffer> buffer = PixelBuffer::map(filepath, dataOffset, static_cast<std::size_t>(dataSize));
+    if (!buffer)
+    {
+        return false;
+    }
+    img = HalfImage(header.width, header.height, buffer);
+
+    // Mark proxy as recently used
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+
+    return true;
+}
+
+void ProxyStore::write(const std::string& path, int downscale, const HalfImage& img)
+{
+    if (_cacheDir.isEmpty())
+    {
+        return;
+    }
+
+    const QString filepath = proxyFilepath(QFileInfo(QString::fromStdString(path)), downscale);
+    if (filepath.isEmpty())
+    {
+        return;
+    }
+
+    // Write to a temporary file first so that concurrent readers never map a partial proxy
+    QSaveFile file(filepath);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        std::cerr << "Failed to write proxy: " << file.fileName().toStdString() << std::endl;
+        return;
+    }
+
+    const ProxyHeader header{proxyMagic, proxyVersion, img.Width(), img.Height()};
+    QByteArray headerPage(static_cast<int>(dataOffset), '\0');
+    std::memcpy(headerPage.data(), &header, sizeof(header));
+    file.write(headerPage);
+    file.write(reinterpret_cast<const char*>(img.data()), static_cast<qint64>(img.memorySize()));
+    if (!file.commit())
+    {
+        return;
+    }
+
+    QMutexLocker lock(&_mutex);
+    _size += static_cast<uint64_t>(dataOffset) + img.memorySize();
+    prune();
+}
+
+uint64_t ProxyStore::getCapacity() const
+{
+    QMutexLocker lock(&_mutex);
+    return _capacity;
+}
+
+void ProxyStore::setCapacity(uint64_t capacity)
+{
+    QMutexLocker lock(&_mutex);
+    _capacity = capacity;
+    prune();
+}
+
+QString ProxyStore::proxyFilepath(const QFileInfo& source, int downscale) const
+{
+    if (!source.exists())
+    {
+        return QString();
+    }
+
+    const QString key = source.absoluteFilePath() + "|" + QString::number(source.lastModified().toMSecsSinceEpoch()) + "|" +
+                        QString::number(source.size()) + "|" + QString::number(downscale);
+    const QByteArray hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return _cacheDir + "/" + QString::fromLatin1(hash) + ".qavp";
+}
+
+void ProxyStore::prune()
+{
+    if (_size <= _capacity || _cacheDir.isEmpty())
+    {
+        return;
+    }
+
+    // Least recently used proxies first (proxies are touched every time they are read)
+    const QFileInfoList files = QDir(_cacheDir).entryInfoList({"*.qavp"}, QDir::Files, QDir::Time | QDir::Reversed);
+
+    uint64_t size = 0;
+    for (const QFileInfo& fileInfo : files)
+    {
+        size += static_cast<uint64_t>(fileInfo.size());
+    }
+
+    // Leave some room to avoid pruning again on the next write
+    const uint64_t targetSize = _capacity / 10 * 8;
+    for (const QFileInfo& fileInfo : files)
+    {
+        if (size <= targetSize)
+        {
+            break;
+        }
+        if (QFile::remove(fileInfo.absoluteFilePath()))
+        {
+            size -= static_cast<uint64_t>(fileInfo.size());
+        }
+    }
+
+    _size = size;
+}
+
+}  // namespace imgserve
+}  // namespace qtAliceVision
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "HalfImage.hpp"
+#include "PixelBuffer.hpp"
+
+#include <QFileInfo>
+#include <QMutex>
+#include <QString>
+
+#include <cstdint>
+#include <string>
+
+namespace qtAliceVision {
+namespace imgserve {
+
+/**
+ * @brief Persistent on-disk store of downscaled images.
+ *
+ * Proxies are stored as raw half float RGBA data behind a one-page header, one file per image and downscale factor,
+ * so that reading one back maps the file in memory instead of decoding the source image.
+ * Proxies read from the store keep their file mapped: their pixels are never copied in process memory.
+ * Files are keyed by source filepath, modification time, size and downscale factor:
+ * modified sources are never matched again and their outdated proxies are pruned over time.
+ * The total size of the store is bounded, least recently used proxies are removed first.
+ *
+ * The store is shared by all image servers of the process and can be accessed from any thread.
+ */
+class ProxyStore
+{
+  public:
+    /// Get the process-wide store.
+    static ProxyStore& instance();
+
+    ProxyStore(const ProxyStore&) = delete;
+    ProxyStore& operator=(const ProxyStore&) = delete;
+
+    /**
+     * @brief Read the proxy of an image.
+     * @param[in] path source image filepath
+     * @param[in] downscale downscale factor
+     * @param[out] img proxy image
+     * @return true if a valid proxy was found, otherwise false
+     */
+    bool read(const std::string& path, int downscale, HalfImage& img);
+
+    /**
+     * @brief Write the proxy of an image, replacing any previous one.
+     * @param[in] path source image filepath
+     * @param[in] downscale downscale factor
+     * @param[in] img proxy image
+     */
+    void write(const std::string& path, int downscale, const HalfImage& img);
+
+    /// Get the maximum size of the store on disk, in bytes.
+    uint64_t getCapacity() const;
+
+    /**
+     * @brief Set the maximum size of the store on disk, removing proxies if needed.
+     * @param[in] capacity maximum size, in bytes
+     */
+    void setCapacity(uint64_t capacity);
+
+  private:
+    ProxyStore();
+
+    /// Filepath of the proxy of an image (empty if the source does not exist).
+    QString proxyFilepath(const QFileInfo& source, int downscale) const;
+
+    /**
+     * @brief Remove least recently used proxies until the store fits in its capacity.
+     * @note must be called with the store mutex locked
+     */
+    void prune();
+
+    /// Directory where proxies are stored (empty if unavailable).
+    QString _cacheDir;
+
+    /// Maximum size of the store, in bytes.
+    uint64_t _capacity;
+
+    /// Current size of the store, in bytes.
+    uint64_t _size = 0;
+
+    /// Store mutex.
+    mutable QMutex _mutex;
+};
+
+}  // namespace imgserve
+}  // namespace qtAliceVision
@@ -1,61 +1,146 @@
 #include "SequenceCache.hpp"
-
-#include <aliceVision/system/MemoryInfo.hpp>
+#include "IOScheduler.hpp"
+#include "MetadataIndex.hpp"
 
 #include <QString>
 #include <QPoint>
+#include <QThread>
 
 #include <algorithm>
 #include <cmath>
-#include <thread>
 #include <chrono>
 #include <stdexcept>
 #include <iostream>
 #include <atomic>
+#include <iterator>
 
 namespace qtAliceVision {
 namespace imgserve {
 
-// Flag for aborting the prefetching worker thread from the main thread
-std::atomic_bool abortPrefetching = false;
+namespace {
 
-SequenceCache::SequenceCache(QObject* parent)
-  : QObject(parent)
+/// Downscale level of a power of two downscale factor (its log2), in [0, 31].
+int downscaleLevel(int downscale)
+{
+    int level = 0;
+    while (level < 31 && (1 << level) < downscale)
+    {
+        ++level;
+    }
+    return level;
+}
+
+}  // namespace
+
+int PrefetchingJob::pull()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    const int nbFrames = static_cast<int>(sequence->size());
+    const bool hasForward = forward < nbFrames;
+    const bool hasBackward = backward >= 0;
+
+    // Walk outward from the requested frame, picking the closest side each time
+    if (hasForward && (!hasBackward || order.distance(forward) <= order.distance(backward)))
+    {
+        return forward++;
+    }
+    if (hasBackward)
+    {
+        return backward--;
+    }
+
+    // All frames have been handed out
+    return -1;
+}
+
+void DecodeLatencies::record(double ms)
 {
-    // Retrieve memory information from system
-    const auto memInfo = aliceVision::system::getMemoryInfo();
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_values.size() < capacity)
+    {
+        _values.push_back(ms);
+        return;
+    }
+    _values[_next] = ms;
+    _next = (_next + 1) % capacity;
+}
 
-    // Compute proportion of RAM that can be dedicated to image caching
-    // For now we use 30% of available RAM
-    const double availableRam = static_cast<double>(memInfo.availableRam);
-    const double cacheRatio = 0.3;
-    const double cacheRam = cacheRatio * availableRam;
+double DecodeLatencies::percentile(double p) const
+{
+    std::vector<double> values;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        values = _values;
+    }
+    if (values.empty())
+    {
+        return 0.0;
+    }
 
-    // Initialize image cache
-    const double factorConvertMiB = 1024. * 1024.;
-    const float fCacheRam = static_cast<float>(cacheRam / factorConvertMiB);
-    _cache = new aliceVision::image::ImageCache(fCacheRam, fCacheRam, aliceVision::image::EImageColorSpace::LINEAR);
+    // Nearest-rank percentile
+    const double rank = std::ceil(std::clamp(p, 0.0, 100.0) / 100.0 * static_cast<double>(values.size()));
+    const std::size_t idx = static_cast<std::size_t>(std::max(1.0, rank)) - 1;
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(idx), values.end());
+    return values[idx];
+}
+
+void DecodeLatencies::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _values.clear();
+    _next = 0;
+}
+
+int64_t PrefetchingJob::now()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+SequenceCache::SequenceCache(QObject* parent)
+  : QObject(parent)
+{
+    // Share the process-wide image cache with other viewers
+    _frameIndex = std::make_shared<std::unordered_map<std::string, int>>();
+    _decodeLatencies = std::make_shared<DecodeLatencies>();
+    _cache = SharedImageCache::acquire();
+    _cache->addClient(this);
 
     // Initialize internal state
     _regionSafe = std::make_pair(-1, -1);
     _loading = false;
     _interactivePrefetching = true;
     _targetSize = 1000;
+    _nbFramesToProbe = 0;
+    _prefetchPolicy = std::make_unique<SymmetricPrefetchPolicy>();
+
+    // By default use half of the cores for decoding images, leaving room for the UI and other loaders
+    setPrefetchingThreads(std::max(1, QThread::idealThreadCount() / 2));
 }
 
 SequenceCache::~SequenceCache()
 {
-    // Check if a worker thread is currently active
-    if (_loading)
+    // Stop metadata scan
+    if (_metadataScan)
+    {
+        _metadataScan->abort = true;
+        _metadataThreadPool.waitForDone();
+    }
+
+    // Cancel prefetching, worker threads will return on next iteration
+    if (_prefetchingJob)
     {
-        // Worker thread will return on next iteration
-        abortPrefetching = true;
-        _threadPool.waitForDone();
+        _prefetchingJob->stop = true;
     }
 
-    // Free memory occupied by image cache
-    if (_cache)
-        delete _cache;
+    // Wait for all workers (including those of cancelled jobs)
+    _threadPool.waitForDone();
+
+    // Drop queued proxies, running ones only hold a reference to the shared image cache
+    IOScheduler::instance().cancel(this);
+
+    // Release our share of the image cache budget
+    _cache->removeClient(this);
 }
 
 void SequenceCache::setSequence(const QVariantList& paths)
@@ -64,139 +149,311 @@ void SequenceCache::setSequence(const QVariantList& paths)
     {
         _sequenceId++;
 
-        abortPrefetching = true;
-        _threadPool.waitForDone();
-        abortPrefetching = false;
+        // Cancel metadata scan of the previous sequence, its workers will stop after their current file
+        if (_metadataScan)
+        {
+            _metadataScan->abort = true;
+        }
+
+        // Cancel prefetching of the previous sequence without waiting for it,
+        // its workers will return after their current image and their completion will be ignored
+        if (_prefetchingJob)
+        {
+            _prefetchingJob->stop = true;
+            _prefetchingJob.reset();
+        }
+        _loading = false;
 
         // Clear internal state
         _sequence.clear();
         _regionSafe = std::make_pair(-1, -1);
 
-        // Fill sequence vector
-        int frameCounter = 0;
+        // Fill sequence vector with frames whose metadata is not known yet
+        auto frameIndex = std::make_shared<std::unordered_map<std::string, int>>();
+        _sequence.reserve(static_cast<std::size_t>(paths.size()));
         for (const auto& var : paths)
         {
-            try
-            {
-                // Initialize frame data
-                FrameData data;
-                data.path = var.toString().toStdString();
-
-                // Retrieve metadata from disk
-                int width, height;
-                auto metadata = aliceVision::image::readImageMetadata(data.path, width, height);
-
-                // Store original image dimensions
-                data.dim = QSize(width, height);
-
-                // Copy metadata into a QVariantMap
-                for (const auto& item : metadata)
-                {
-                    data.metadata[QString::fromStdString(item.name().string())] = QString::fromStdString(item.get_string());
-                }
-
-                // Compute downscale
-                const int maxDim = std::max(width, height);
-                const int level = static_cast<int>(std::floor(std::log2(static_cast<double>(maxDim) / static_cast<double>(_targetSize))));
-                data.downscale = 1 << std::max(level, 0);
-
-                // Set frame number
-                data.frame = frameCounter;
-
-                // Add to sequence
-                _sequence.push_back(data);
-                ++frameCounter;
-            }
-            catch (const std::runtime_error& e)
-            {
-                // Log error
-                std::cerr << e.what() << std::endl;
-            }
+            // Initialize frame data
+            FrameData data;
+            data.path = var.toString().toStdString();
+            data.frame = static_cast<int>(_sequence.size());
+            data.downscale = 1;
+
+            // Add to sequence and index it by filepath (first occurrence wins, as with the former linear scan)
+            frameIndex->emplace(data.path, data.frame);
+            _sequence.push_back(data);
+        }
+
+        // Publish new index for eviction advisory, forget pinned frames and position of previous sequence
+        {
+            std::lock_guard<std::mutex> lock(_evictionMutex);
+            _frameIndex = std::move(frameIndex);
+            _pinnedPaths.clear();
+            _playhead = PrefetchOrder();
+
+            // Cached frames are known once cache content has been notified and frames have been probed
+            _cachedLevels.assign(_sequence.size(), 0);
+            _targetLevels.assign(_sequence.size(), -1);
+            _cachedIntervals.clear();
         }
+
+        _nbFramesToProbe = static_cast<int>(_sequence.size());
+        _snapshot.reset();
     }
     _lockSequence.unlock();
 
+    // Images of the new sequence may already be in cache (e.g. loaded by another viewer)
+    _cache->notifyContent(this);
+
+    // Retrieve metadata from disk in background workers
+    if (!_sequence.empty())
+    {
+        _metadataScan = std::make_shared<MetadataScan>();
+        _metadataScan->paths.reserve(_sequence.size());
+        for (const auto& data : _sequence)
+        {
+            _metadataScan->paths.push_back(data.path);
+        }
+
+        _probeTimer.start();
+
+        const int nbWorkers = std::min(_metadataThreadPool.maxThreadCount(), static_cast<int>(_sequence.size()));
+        _metadataScan->nbRunning = nbWorkers;
+        for (int i = 0; i < nbWorkers; ++i)
+        {
+            auto ioRunnable = new MetadataIORunnable(_metadataScan, _sequenceId.loadAcquire());
+            connect(ioRunnable, &MetadataIORunnable::probed, this, &SequenceCache::onFrameProbed);
+            _metadataThreadPool.start(ioRunnable);
+        }
+    }
+
     // Notify listeners that sequence content has changed
     Q_EMIT contentChanged();
 }
 
+void SequenceCache::setCacheCapacity(uint64_t capacity) { _cache->setCapacity(capacity); }
+
+void SequenceCache::setCacheCapacityRatio(double ratio) { _cache->setCapacityRatio(ratio); }
+
+void SequenceCache::setEvictionPolicy(EEvictionPolicy policy) { _cache->setEvictionPolicy(policy); }
+
+void SequenceCache::setStorageMode(EStorageMode mode) { _cache->setStorageMode(mode); }
+
+void SequenceCache::setPersistentCache(bool persistent) { _cache->setPersistent(persistent); }
+
+void SequenceCache::setPinnedFrames(const QVariantList& frames)
+{
+    std::unordered_set<std::string> pinnedPaths;
+    for (const auto& var : frames)
+    {
+        const int frame = var.toInt();
+        if (frame >= 0 && frame < static_cast<int>(_sequence.size()))
+        {
+            pinnedPaths.insert(_sequence[static_cast<std::size_t>(frame)].path);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_evictionMutex);
+    _pinnedPaths = std::move(pinnedPaths);
+}
+
+double SequenceCache::evictionDistance(const std::string& path) const
+{
+    std::lock_guard<std::mutex> lock(_evictionMutex);
+
+    const auto it = _frameIndex->find(path);
+    if (it == _frameIndex->end())
+    {
+        return -1.;
+    }
+
+    // Use the prefetching order around the last request, so that eviction favors the direction of travel
+    return _playhead.distance(it->second);
+}
+
+bool SequenceCache::isPinned(const std::string& path) const
+{
+    std::lock_guard<std::mutex> lock(_evictionMutex);
+    return _pinnedPaths.find(path) != _pinnedPaths.end();
+}
+
 void SequenceCache::setInteractivePrefetching(bool interactive) { _interactivePrefetching = interactive; }
 
+void SequenceCache::setProgressive(bool progressive) { _progressive = progressive; }
+
+void SequenceCache::setPrefetchPolicy(std::unique_ptr<PrefetchPolicy> policy)
+{
+    if (!policy)
+    {
+        return;
+    }
+
+    // Keep the direction and velocity of requests, so that the first prefetch after a switch goes the right way
+    if (_prefetchPolicy)
+    {
+        policy->inheritTracking(*_prefetchPolicy);
+    }
+    _prefetchPolicy = std::move(policy);
+
+    // Re-evaluate prefetching on next request
+    if (!_loading)
+    {
+        _regionSafe = std::make_pair(-1, -1);
+    }
+}
+
+void SequenceCache::setPrefetchingThreads(int nbThreads)
+{
+    // Takes effect on next prefetching launch
+    _prefetchingThreads = std::max(1, nbThreads);
+    _threadPool.setMaxThreadCount(_prefetchingThreads);
+}
+
 void SequenceCache::setTargetSize(int size)
 {
     // Update target size
     _targetSize = size;
 
+    if (updateDownscales())
+    {
+        // Notify listeners that sequence content has changed
+        Q_EMIT contentChanged();
+    }
+}
+
+bool SequenceCache::updateDownscales()
+{
+    std::lock_guard<std::mutex> lock(_evictionMutex);
+
     // Update downscale for each frame
     bool refresh = false;
     for (auto& data : _sequence)
     {
-        // Compute downscale
-        const int maxDim = std::max(data.dim.width(), data.dim.height());
-        const int level = static_cast<int>(std::floor(std::log2(static_cast<double>(maxDim) / static_cast<double>(_targetSize))));
-        const int downscale = 1 << std::max(level, 0);
+        // Frames whose metadata is not known yet will get their downscale once probed
+        if (data.dim.isEmpty())
+        {
+            continue;
+        }
+
+        const int downscale = computeDownscale(data.dim);
 
         refresh = refresh || (data.downscale != downscale);
 
         data.downscale = downscale;
+
+        // Cached intervals follow the new target downscale
+        _targetLevels[static_cast<std::size_t>(data.frame)] = downscaleLevel(downscale);
+        updateCachedIntervals(data.frame);
     }
 
     if (refresh)
     {
         // Clear internal state
         _regionSafe = std::make_pair(-1, -1);
-
-        // Notify listeners that sequence content has changed
-        Q_EMIT contentChanged();
+        _snapshot.reset();
     }
+
+    return refresh;
 }
 
 QVariantList SequenceCache::getCachedFrames() const
 {
     QVariantList intervals;
 
-    // Accumulator variables
-    auto region = std::make_pair(-1, -1);
-    bool regionOpen = false;
+    std::lock_guard<std::mutex> lock(_evictionMutex);
+    for (const auto& interval : _cachedIntervals)
+    {
+        intervals.append(QPoint(interval.first, interval.second));
+    }
 
-    // Build cached frames intervals
-    for (std::size_t i = 0; i < _sequence.size(); ++i)
+    return intervals;
+}
+
+void SequenceCache::onImageInserted(const std::string& path, int downscale)
+{
+    std::lock_guard<std::mutex> lock(_evictionMutex);
+
+    const auto it = _frameIndex->find(path);
+    if (it == _frameIndex->end())
+    {
+        return;
+    }
+
+    _cachedLevels[static_cast<std::size_t>(it->second)] |= 1u << downscaleLevel(downscale);
+    updateCachedIntervals(it->second);
+}
+
+void SequenceCache::onImageEvicted(const std::string& path, int downscale)
+{
+    std::lock_guard<std::mutex> lock(_evictionMutex);
+
+    const auto it = _frameIndex->find(path);
+    if (it == _frameIndex->end())
+    {
+        return;
+    }
+
+    _cachedLevels[static_cast<std::size_t>(it->second)] &= ~(1u << downscaleLevel(downscale));
+    updateCachedIntervals(it->second);
+}
+
+void SequenceCache::onCapacityChanged(uint64_t capacity)
+{
+    (void)capacity;
+
+    // Called with the cache locked, possibly from another thread: listeners are notified from the event loop
+    QMetaObject::invokeMethod(this, [this]() { Q_EMIT cacheCapacityChanged(); }, Qt::QueuedConnection);
+}
+
+void SequenceCache::updateCachedIntervals(int frame)
+{
+    const std::size_t idx = static_cast<std::size_t>(frame);
+    const int level = _targetLevels[idx];
+    const bool cached = level >= 0 && ((_cachedLevels[idx] >> level) & 1u) != 0;
+
+    // Interval containing the frame, if any, is the last one starting at or before it
+    const auto next = _cachedIntervals.upper_bound(frame);
+    auto prev = (next == _cachedIntervals.begin()) ? _cachedIntervals.end() : std::prev(next);
+    const bool inInterval = prev != _cachedIntervals.end() && prev->second >= frame;
+    if (cached == inInterval)
     {
-        const int frame = static_cast<int>(i);
+        return;
+    }
 
-        // Check if current frame is in cache
-        if (_cache->contains<aliceVision::image::RGBAfColor>(_sequence[i].path, _sequence[i].downscale))
+    if (cached)
+    {
+        // Extend the previous interval or open a new one, then merge with the next interval if contiguous
+        if (prev != _cachedIntervals.end() && prev->second == frame - 1)
         {
-            // Either grow currently open region or create a new region
-            if (regionOpen)
-            {
-                region.second = frame;
-            }
-            else
-            {
-                region.first = frame;
-                region.second = frame;
-                regionOpen = true;
-            }
+            prev->second = frame;
         }
         else
         {
-            // Close currently open region
-            if (regionOpen)
-            {
-                intervals.append(QPoint(region.first, region.second));
-                regionOpen = false;
-            }
+            prev = _cachedIntervals.emplace(frame, frame).first;
+        }
+        if (next != _cachedIntervals.end() && next->first == frame + 1)
+        {
+            prev->second = next->second;
+            _cachedIntervals.erase(next);
         }
     }
-
-    // Last region may still be open
-    if (regionOpen)
+    else
     {
-        intervals.append(QPoint(region.first, region.second));
+        // Split the interval around the frame
+        const int last = prev->second;
+        if (prev->first == frame)
+        {
+            _cachedIntervals.erase(prev);
+        }
+        else
+        {
+            prev->second = frame - 1;
+        }
+        if (last > frame)
+        {
+            _cachedIntervals.emplace(frame + 1, last);
+        }
     }
-
-    return intervals;
 }
 
 ResponseData SequenceCache::request(const RequestData& reqData)
@@ -212,14 +469,58 @@ ResponseData SequenceCache::request(const RequestData& reqData)
         return response;
     }
 
+    // Frames larger than the maximum size requested by the viewer are downscaled further at load time
+    if (reqData.maxSize != _maxSize)
+    {
+        _maxSize = reqData.maxSize;
+        updateDownscales();
+    }
+
+    // Keep track of scrub direction and speed
+    _prefetchPolicy->update(frame);
+
+    // Keep track of current position for eviction
+    {
+        std::lock_guard<std::mutex> lock(_evictionMutex);
+        _playhead = _prefetchPolicy->order(frame);
+    }
+
     // Retrieve frame data
     const std::size_t idx = static_cast<std::size_t>(frame);
     const FrameData& data = _sequence[idx];
 
+    // Metadata of the requested image has not been retrieved yet
+    if (data.dim.isEmpty())
+    {
+        // Empty response, listeners will be notified once the frame has been probed
+        return response;
+    }
+
     // Retrieve image from cache
-    const bool cachedOnly = true;
-    const bool lazyCleaning = false;
-    response.img = _cache->get<aliceVision::image::RGBAfColor>(data.path, data.downscale, cachedOnly, lazyCleaning);
+    const CachedImage cached = _cache->get(data.path, data.downscale);
+    response.img = cached.img;
+    response.halfImg = cached.halfImg;
+    response.bytesCopied = cached.bytesCopied;
+
+    // Requested image is not in cache: fall back to a low resolution proxy in progressive mode
+    if (!cached && _progressive)
+    {
+        // Proxies are at most 8 times smaller than the requested image
+        const int proxyDownscale = data.downscale * 8;
+        const CachedImage proxy = _cache->getCoarser(data.path, data.downscale, proxyDownscale);
+        if (proxy)
+        {
+            response.img = proxy.img;
+            response.halfImg = proxy.halfImg;
+            response.bytesCopied = proxy.bytesCopied;
+            response.proxy = true;
+        }
+        else if (data.dim.width() >= proxyDownscale && data.dim.height() >= proxyDownscale)
+        {
+            // Listeners will be notified once the proxy is available
+            loadProxy(data.path, proxyDownscale);
+        }
+    }
 
     // Retrieve metadata
     response.dim = data.dim;
@@ -227,35 +528,82 @@ ResponseData SequenceCache::request(const RequestData& reqData)
 
     // Requested image is not in cache
     // and there is already a prefetching thread running
-    if (!response.img && _loading && _interactivePrefetching)
+    if (!cached && _loading && _interactivePrefetching)
     {
-        // Abort prefetching to avoid waiting until current worker thread is done
-        abortPrefetching = true;
+        // Abort prefetching to avoid waiting until current worker threads are done
+        _prefetchingJob->stop = true;
     }
 
     // Request falls outside of safe region
     if ((frame < _regionSafe.first || frame > _regionSafe.second) && !_loading)
     {
-        // Make sur abort flag is off before launching a new prefetching thread
-        abortPrefetching = false;
-
         // Update internal state
         _loading = true;
 
+        // Allow worker threads to fill an equal share of the cache capacity for each viewer
+        const double fillRatio = 1. / static_cast<double>(std::max(1, _cache->getNbClients()));
+
         // Gather images to load
-        std::vector<FrameData> toLoad = _sequence;
+        auto job = std::make_shared<PrefetchingJob>();
+        job->sequence = getSnapshot();
+        job->order = _prefetchPolicy->order(frame);
+        job->forward = frame;
+        job->backward = frame - 1;
+        job->toFill = static_cast<uint64_t>(static_cast<double>(_cache->getCapacity()) * fillRatio);
+        job->bytesPerPixel = _cache->getBytesPerPixel();
+        job->lastProgress = PrefetchingJob::now();
+        job->latencies = _decodeLatencies;
+        job->nbRunning = _prefetchingThreads;
+        _prefetchingJob = job;
+
+        // Create new runnables sharing the job and launch them in worker threads (managed by local thread pool)
+        for (int i = 0; i < _prefetchingThreads; ++i)
+        {
+            auto ioRunnable = new PrefetchingIORunnable(_cache, job, _sequenceId.loadAcquire());
+            connect(ioRunnable, &PrefetchingIORunnable::progressed, this, &SequenceCache::onPrefetchingProgressed);
+            connect(ioRunnable, &PrefetchingIORunnable::done, this, &SequenceCache::onPrefetchingDone);
+            _threadPool.start(ioRunnable);
+        }
+    }
 
-        // For now fill the allow worker thread to fill the whole cache capacity
-        const double fillRatio = 1.;
+    return response;
+}
 
-        // Create new runnable and launch it in worker thread (managed by Qt thread pool)
-        auto ioRunnable = new PrefetchingIORunnable(_cache, toLoad, frame, fillRatio, _sequenceId.loadAcquire());
-        connect(ioRunnable, &PrefetchingIORunnable::progressed, this, &SequenceCache::onPrefetchingProgressed);
-        connect(ioRunnable, &PrefetchingIORunnable::done, this, &SequenceCache::onPrefetchingDone);
-        _threadPool.start(ioRunnable);
+void SequenceCache::onFrameProbed(int sequenceId, int frame, QSize dim, QVariantMap metadata)
+{
+    // Discard results from the metadata scan of a previous sequence
+    if (sequenceId != _sequenceId)
+    {
+        return;
     }
 
-    return response;
+    _lockSequence.lock();
+    {
+        // Store metadata and compute downscale
+        FrameData& data = _sequence[static_cast<std::size_t>(frame)];
+        data.dim = dim;
+        data.metadata = metadata;
+        data.downscale = dim.isEmpty() ? 1 : computeDownscale(dim);
+
+        // Snapshots are shared with jobs: the frame is added by the next rebuild
+        _snapshotOutdated = true;
+
+        // Frames that could not be probed are never loaded
+        std::lock_guard<std::mutex> lock(_evictionMutex);
+        _targetLevels[static_cast<std::size_t>(frame)] = dim.isEmpty() ? -1 : downscaleLevel(data.downscale);
+        updateCachedIntervals(frame);
+
+        --_nbFramesToProbe;
+    }
+    _lockSequence.unlock();
+
+    // Notify listeners that sequence content has changed,
+    // throttled to avoid refreshing clients for every single frame
+    if (_nbFramesToProbe == 0 || _probeTimer.elapsed() > 100)
+    {
+        _probeTimer.restart();
+        Q_EMIT contentChanged();
+    }
 }
 
 void SequenceCache::onPrefetchingProgressed(int)
@@ -267,17 +615,22 @@ void SequenceCache::onPrefetchingProgressed(int)
 void SequenceCache::onPrefetchingDone(int sequenceId, int reqFrame)
 {
     // Make sure the fetching concerns the actual sequence Id
+    // Jobs cancelled by a sequence change are not tracked anymore and must not reset the loading state
     bool exitOld = false;
     _lockSequence.lock();
     if (sequenceId != _sequenceId)
     {
         exitOld = true;
     }
-    if (reqFrame >= _sequence.size())
+    else
+    {
+        _loading = false;
+        _prefetchingJob.reset();
+    }
+    if (reqFrame >= static_cast<int>(_sequence.size()))
     {
         exitOld = true;
     }
-    _loading = false;
     _lockSequence.unlock();
 
     if (exitOld)
@@ -295,7 +648,7 @@ void SequenceCache::onPrefetchingDone(int sequenceId, int reqFrame)
             const std::size_t idx = static_cast<std::size_t>(frame);
 
             // Grow region on the left as much as possible
-            if (_cache->contains<aliceVision::image::RGBAfColor>(_sequence[idx].path, _sequence[idx].downscale))
+            if (_cache->contains(_sequence[idx].path, _sequence[idx].downscale))
             {
                 regionCached.first = frame;
             }
@@ -309,7 +662,7 @@ void SequenceCache::onPrefetchingDone(int sequenceId, int reqFrame)
             const std::size_t idx = static_cast<std::size_t>(frame);
 
             // Grow region on the right as much as possible
-            if (_cache->contains<aliceVision::image::RGBAfColor>(_sequence[idx].path, _sequence[idx].downscale))
+            if (_cache->contains(_sequence[idx].path, _sequence[idx].downscale))
             {
                 regionCached.second = frame;
             }
@@ -326,11 +679,7 @@ void SequenceCache::onPrefetchingDone(int sequenceId, int reqFrame)
         }
         else
         {
-            // Here we define safe region to cover 80% of cached region
-            // The remaining 20% serves to anticipate prefetching
-            const int extentCached = (regionCached.second - regionCached.first) / 2;
-            const int extentSafe = static_cast<int>(static_cast<double>(extentCached) * 0.8);
-            _regionSafe = buildRegion(reqFrame, extentSafe);
+            _regionSafe = _prefetchPolicy->safeRegion(regionCached, reqFrame, static_cast<int>(_sequence.size()));
         }
     }
     _lockSequence.unlock();
@@ -339,98 +688,195 @@ void SequenceCache::onPrefetchingDone(int sequenceId, int reqFrame)
     Q_EMIT requestHandled();
 }
 
+void SequenceCache::onProxyLoaded(int sequenceId)
+{
+    // Discard proxies of a previous sequence
+    if (sequenceId != _sequenceId)
+    {
+        return;
+    }
+
+    // Notify clients that a proxy is available for the last request
+    Q_EMIT requestHandled();
+}
+
+void SequenceCache::loadProxy(const std::string& path, int downscale)
+{
+    // Proxies queued for previous requests are obsolete
+    IOScheduler::instance().cancel(this);
+
+    // Proxies are interactive loads, they never wait for prefetching
+    auto ioRunnable = new ProxyIORunnable(_cache, path, downscale, _sequenceId.loadAcquire());
+    connect(ioRunnable, &ProxyIORunnable::loaded, this, &SequenceCache::onProxyLoaded);
+    IOScheduler::instance().start(IOScheduler::EIOClass::Interactive, ioRunnable, this);
+}
+
 int SequenceCache::getFrame(const std::string& path) const
 {
-    // Go through frames until we find a matching filepath
-    for (int idx = 0; idx < _sequence.size(); ++idx)
+    // Look up filepath in the frame index
+    const auto it = _frameIndex->find(path);
+    if (it == _frameIndex->end())
     {
-        if (_sequence[idx].path == path)
-        {
-            return idx;
-        }
+        // No match found
+        return -1;
     }
 
-    // No match found
-    return -1;
+    return it->second;
 }
 
-std::pair<int, int> SequenceCache::buildRegion(int frame, int extent) const
+std::string SequenceCache::getFramePath(int frame) const
 {
-    // Initialize region equally around central frame
-    int start = frame - extent;
-    int end = frame + extent;
+    if (frame < 0 || frame >= getNbFrames())
+    {
+        return std::string();
+    }
+    return _sequence[static_cast<std::size_t>(frame)].path;
+}
 
-    // Adjust to sequence bounds
-    if (start < 0)
+bool SequenceCache::isCached(int frame) const
+{
+    if (frame < 0 || frame >= getNbFrames())
     {
-        start = 0;
-        end = std::min(static_cast<int>(_sequence.size()) - 1, 2 * extent);
+        return false;
     }
-    else if (end >= static_cast<int>(_sequence.size()))
+
+    // Frames whose metadata has not been retrieved yet have no known target resolution
+    const FrameData& data = _sequence[static_cast<std::size_t>(frame)];
+    return !data.dim.isEmpty() && _cache->contains(data.path, data.downscale);
+}
+
+SequenceSnapshot SequenceCache::getSnapshot()
+{
+    // Snapshot is only rebuilt when sequence content has changed since the last prefetching launch
+    // Rebuilding is O(sequence length): during the metadata scan, probed frames are added by periodic rebuilds
+    const bool outdated = _snapshotOutdated && (_nbFramesToProbe == 0 || _snapshotTimer.elapsed() > 500);
+    if (!_snapshot || outdated)
     {
-        end = static_cast<int>(_sequence.size()) - 1;
-        start = std::max(0, static_cast<int>(_sequence.size()) - 1 - 2 * extent);
+        auto snapshot = std::make_shared<std::vector<FrameInfo>>();
+        snapshot->reserve(_sequence.size());
+        for (const auto& data : _sequence)
+        {
+            snapshot->push_back({data.path, data.dim, data.frame, data.downscale});
+        }
+        _snapshot = std::move(snapshot);
+        _snapshotOutdated = false;
+        _snapshotTimer.restart();
     }
 
-    return std::make_pair(start, end);
+    return _snapshot;
 }
 
-PrefetchingIORunnable::PrefetchingIORunnable(aliceVision::image::ImageCache* cache,
-                                             const std::vector<FrameData>& toLoad,
-                                             int reqFrame,
-                                             double fillRatio,
-                                             int sequenceId)
-  : _cache(cache),
-    _toLoad(toLoad),
-    _reqFrame(reqFrame),
-    _sequenceId(sequenceId)
+int SequenceCache::computeDownscale(const QSize& dim) const
 {
-    _toFill = static_cast<uint64_t>(static_cast<double>(_cache->info().capacity) * fillRatio);
+    const int maxDim = std::max(dim.width(), dim.height());
+    const int level = static_cast<int>(std::floor(std::log2(static_cast<double>(maxDim) / static_cast<double>(_targetSize))));
+    int downscale = 1 << std::max(level, 0);
+
+    // Never exceed the maximum size, whatever the target size
+    while (_maxSize > 0 && (maxDim + downscale - 1) / downscale > _maxSize)
+    {
+        downscale *= 2;
+    }
+    return downscale;
 }
 
-PrefetchingIORunnable::~PrefetchingIORunnable() {}
+MetadataIORunnable::MetadataIORunnable(const std::shared_ptr<MetadataScan>& scan, int sequenceId)
+  : _scan(scan),
+    _sequenceId(sequenceId)
+{}
 
-void PrefetchingIORunnable::run()
+MetadataIORunnable::~MetadataIORunnable() {}
+
+void MetadataIORunnable::run()
 {
-    using namespace std::chrono_literals;
+    const int nbFrames = static_cast<int>(_scan->paths.size());
 
-    // Timer for sending progress signals
-    auto tRef = std::chrono::high_resolution_clock::now();
+    // Pull frames in sequence order until all of them have been probed or the scan is cancelled
+    while (!_scan->abort)
+    {
+        const int frame = _scan->next++;
+        if (frame >= nbFrames)
+        {
+            break;
+        }
 
-    // Processing order:
-    // Sort frames by distance to request frame
-    std::sort(_toLoad.begin(), _toLoad.end(), [this](const FrameData& lhs, const FrameData& rhs) {
-        return std::abs(lhs.frame - _reqFrame) < std::abs(rhs.frame - _reqFrame);
-    });
+        QSize dim;
+        QVariantMap metadata;
 
-    // Accumulator variable to keep track of cache capacity filled with loaded images
-    uint64_t filled = 0;
+        try
+        {
+            // Retrieve metadata from the persistent index, or from disk if the file is unknown or was modified
+            MetadataIndex::instance().read(_scan->paths[static_cast<std::size_t>(frame)], dim, metadata);
+        }
+        catch (const std::runtime_error& e)
+        {
+            // Log error
+            std::cerr << e.what() << std::endl;
+        }
 
-    // Load images from disk to cache
-    for (const auto& data : _toLoad)
+        // Frames that failed are still reported (with empty dimensions) to keep track of progress
+        Q_EMIT probed(_sequenceId, frame, dim, metadata);
+    }
+
+    // Last worker to finish persists the newly indexed frames
+    if (--_scan->nbRunning == 0 && !_scan->abort)
     {
-        // Check if main thread wants to abort prefetching
-        if (abortPrefetching)
+        MetadataIndex::instance().flush();
+    }
+}
+
+PrefetchingIORunnable::PrefetchingIORunnable(const std::shared_ptr<SharedImageCache>& cache, const std::shared_ptr<PrefetchingJob>& job, int sequenceId)
+  : _cache(cache),
+    _job(job),
+    _reqFrame(job->order.reqFrame),
+    _sequenceId(sequenceId)
+{}
+
+PrefetchingIORunnable::~PrefetchingIORunnable() {}
+
+void PrefetchingIORunnable::run()
+{
+    // Load images from disk to cache, pulling frames from the shared queue until the job stops
+    // Main thread can cancel the job at any time through its stop flag
+    while (!_job->stop)
+    {
+        // Processing order:
+        // Frames by distance to request frame, as defined by the prefetch policy
+        // Each frame is handed to a single worker
+        const int frame = _job->pull();
+        if (frame < 0)
         {
-            abortPrefetching = false;
-            Q_EMIT done(_sequenceId, _reqFrame);
-            return;
+            break;
         }
+        const FrameInfo& data = (*_job->sequence)[static_cast<std::size_t>(frame)];
 
-        // Check if image size does not exceed limit
-        uint64_t memSize = static_cast<uint64_t>(data.dim.width() / data.downscale) * static_cast<uint64_t>(data.dim.height() / data.downscale) * 16;
-        if (filled + memSize > _toFill)
+        // Skip frames whose metadata could not be retrieved
+        if (data.dim.isEmpty())
         {
+            continue;
+        }
+
+        // Reserve cache capacity for this image, stop the job when the limit would be exceeded
+        const uint64_t memSize =
+          static_cast<uint64_t>(data.dim.width() / data.downscale) * static_cast<uint64_t>(data.dim.height() / data.downscale) * _job->bytesPerPixel;
+        if (_job->filled.fetch_add(memSize) + memSize > _job->toFill)
+        {
+            _job->stop = true;
             break;
         }
 
-        // Load image in cache
+        // Load image in cache (or wait for another viewer already loading it)
+        // Only actual loads are timed, images found in cache would bias latency statistics
         try
         {
-            const bool cachedOnly = false;
-            const bool lazyCleaning = false;
-            _cache->get<aliceVision::image::RGBAfColor>(data.path, data.downscale, cachedOnly, lazyCleaning);
-            filled += memSize;
+            const bool cached = _cache->contains(data.path, data.downscale);
+            const auto tStart = std::chrono::steady_clock::now();
+            _cache->load(data.path, data.downscale);
+            if (!cached)
+            {
+                const std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now() - tStart;
+                _job->latencies->record(latency.count());
+            }
         }
         catch (const std::runtime_error& e)
         {
@@ -438,21 +884,53 @@ void PrefetchingIORunnable::run()
             std::cerr << e.what() << std::endl;
         }
 
-        // Wait a few milliseconds in case another thread needs to query the cache
-        std::this_thread::sleep_for(1ms);
-
-        // Regularly send progress signals
-        auto tNow = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> diff = tNow - tRef;
-        if (diff.count() > 1.)
+        // Regularly send progress signals (at most once per second for the whole job)
+        // The requested frame is signaled as soon as it is loaded, so that clients can display it right away
+        const int64_t tNow = PrefetchingJob::now();
+        int64_t tRef = _job->lastProgress;
+        if (frame == _reqFrame)
         {
-            tRef = tNow;
+            _job->lastProgress = tNow;
             Q_EMIT progressed(_reqFrame);
         }
+        else if (tNow - tRef > 1000 && _job->lastProgress.compare_exchange_strong(tRef, tNow))
+        {
+            Q_EMIT progressed(_reqFrame);
+        }
+    }
+
+    // Last worker to finish notifies main thread that loading is done
+    if (--_job->nbRunning == 0)
+    {
+        Q_EMIT done(_sequenceId, _reqFrame);
+    }
+}
+
+ProxyIORunnable::ProxyIORunnable(const std::shared_ptr<SharedImageCache>& cache, const std::string& path, int downscale, int sequenceId)
+  : _cache(cache),
+    _path(path),
+    _downscale(downscale),
+    _sequenceId(sequenceId)
+{}
+
+ProxyIORunnable::~ProxyIORunnable() {}
+
+void ProxyIORunnable::run()
+{
+    try
+    {
+        // Load proxy in cache (or wait for another thread already loading it)
+        _cache->load(_path, _downscale);
+    }
+    catch (const std::runtime_error& e)
+    {
+        // Log error message
+        std::cerr << e.what() << std::endl;
+        return;
     }
 
-    // Notify main thread that loading is done
-    Q_EMIT done(_sequenceId, _reqFrame);
+    // Notify main thread that the proxy is available
+    Q_EMIT loaded(_sequenceId);
 }
 
 }  // namespace imgserve
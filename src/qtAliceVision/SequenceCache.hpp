@@ -1,6 +1,8 @@
 #pragma once
 
 #include "ImageServer.hpp"
+#include "PrefetchPolicy.hpp"
+#include "SharedImageCache.hpp"
 
 #include <aliceVision/image/all.hpp>
 
@@ -13,18 +15,27 @@
 #include <QThreadPool>
 #include <QAtomicInt>
 #include <QMutex>
+#include <QElapsedTimer>
 
 #include <string>
 #include <vector>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <memory>
+#include <atomic>
+#include <mutex>
 #include <cstdint>
 
 namespace qtAliceVision {
 namespace imgserve {
 
+struct PrefetchingJob;
+
 /**
  * @brief Utility struct for manipulating various information about a given frame.
+ * @note dim is empty as long as the frame metadata has not been retrieved from disk
  */
 struct FrameData
 {
@@ -39,6 +50,81 @@ struct FrameData
     int downscale;
 };
 
+/**
+ * @brief Lightweight description of a frame, sufficient for loading it from disk.
+ */
+struct FrameInfo
+{
+    std::string path;
+
+    QSize dim;
+
+    int frame;
+
+    int downscale;
+};
+
+/**
+ * @brief Immutable view of a sequence shared with worker threads.
+ *
+ * Prefetching jobs hold a reference to the snapshot instead of copying the sequence,
+ * so launching a job does not copy frame metadata.
+ */
+using SequenceSnapshot = std::shared_ptr<const std::vector<FrameInfo>>;
+
+/**
+ * @brief Shared state of a metadata scan, split between several worker threads.
+ */
+struct MetadataScan
+{
+    /// Filepaths of the frames to probe, in sequence order.
+    std::vector<std::string> paths;
+
+    /// Next frame to probe.
+    std::atomic_int next = 0;
+
+    /// Number of workers still running.
+    std::atomic_int nbRunning = 0;
+
+    /// Flag for cancelling the scan from the main thread.
+    std::atomic_bool abort = false;
+};
+
+/**
+ * @brief Thread-safe record of the most recent image decoding times, for latency statistics.
+ */
+class DecodeLatencies
+{
+  public:
+    /// Number of decoding times kept, older ones are replaced.
+    static constexpr std::size_t capacity = 512;
+
+    /**
+     * @brief Record the time taken to decode an image.
+     * @param[in] ms decoding time, in milliseconds
+     */
+    void record(double ms);
+
+    /**
+     * @brief Get a percentile of recorded decoding times.
+     * @param[in] p percentile, in [0, 100]
+     * @return the decoding time below which p percent of recorded times fall, in milliseconds (0 if none has been recorded)
+     */
+    double percentile(double p) const;
+
+    /// Forget all recorded decoding times.
+    void clear();
+
+  private:
+    mutable std::mutex _mutex;
+
+    /// Ring buffer of decoding times, in milliseconds.
+    std::vector<double> _values;
+
+    /// Position of the next record in the ring buffer, once full.
+    std::size_t _next = 0;
+};
+
 /**
  * @brief Image server with a caching system for loading image sequences from disk.
  *
@@ -50,8 +136,11 @@ struct FrameData
  * (a region being a contiguous range of images from the sequence).
  * Such strategy makes sense under the assumption that the sequence order is meaningful for clients,
  * i.e. that if an image is queried then it is likely that the next queries will be close in the sequence.
+ *
+ * Loaded images are stored in the process-wide SharedImageCache,
+ * so that several SequenceCache instances displaying the same images share them and a single memory budget.
  */
-class SequenceCache : public QObject, public ImageServer
+class SequenceCache : public QObject, public ImageServer, public EvictionAdvisor
 {
     Q_OBJECT
 
@@ -69,15 +158,96 @@ class SequenceCache : public QObject, public ImageServer
      * @brief Set the current image sequence.
      * @param[in] paths unordered list of image filepaths
      * @note the sequence order will not be changed
+     * @note frame metadata is retrieved asynchronously, contentChanged is emitted as frames get probed
      */
     void setSequence(const QVariantList& paths);
 
+    /**
+     * @brief Set the memory budget of the image cache shared by all viewers.
+     * @param[in] capacity memory budget, in bytes
+     */
+    void setCacheCapacity(uint64_t capacity);
+
+    /**
+     * @brief Set the memory budget of the image cache shared by all viewers as a proportion of available RAM.
+     * @param[in] ratio proportion of available RAM, in [0, 1]
+     */
+    void setCacheCapacityRatio(double ratio);
+
+    /// Get the memory budget of the image cache shared by all viewers, in bytes.
+    uint64_t getCacheCapacity() const { return _cache->getCapacity(); }
+
+    /// Get the memory budget of the image cache shared by all viewers, as a proportion of available RAM.
+    double getCacheCapacityRatio() const { return _cache->getCapacityRatio(); }
+
+    /**
+     * @brief Set the strategy used by the image cache shared by all viewers to evict images.
+     * @param[in] policy eviction policy
+     */
+    void setEvictionPolicy(EEvictionPolicy policy);
+
+    /// Get the strategy used by the image cache shared by all viewers to evict images.
+    EEvictionPolicy getEvictionPolicy() const { return _cache->getEvictionPolicy(); }
+
+    /**
+     * @brief Set the precision used by the image cache shared by all viewers to store newly loaded images.
+     * @param[in] mode storage mode
+     */
+    void setStorageMode(EStorageMode mode);
+
+    /// Get the precision used by the image cache shared by all viewers to store newly loaded images.
+    EStorageMode getStorageMode() const { return _cache->getStorageMode(); }
+
+    /**
+     * @brief Toggle on/off the persistent on-disk store of downscaled frames, shared by all viewers.
+     * @param[in] persistent new value for the persistent flag
+     */
+    void setPersistentCache(bool persistent);
+
+    /// Check if downscaled frames are read from and written to the persistent on-disk store.
+    bool getPersistentCache() const { return _cache->isPersistent(); }
+
+    /**
+     * @brief Set the frames to keep in cache with the Keyframes eviction policy.
+     * @param[in] frames list of frame numbers in the current sequence
+     */
+    void setPinnedFrames(const QVariantList& frames);
+
     /**
      * @brief Toggle on/off interactive prefetching.
      * @param[in] interactive new value for interactive prefetching flag
      */
     void setInteractivePrefetching(bool interactive);
 
+    /**
+     * @brief Set the strategy deciding which frames are prefetched around requests.
+     * @param[in] policy new prefetch policy (ignored if null)
+     * @note the new policy applies from the next prefetching launch, with the request direction and velocity of the previous one
+     */
+    void setPrefetchPolicy(std::unique_ptr<PrefetchPolicy> policy);
+
+    /**
+     * @brief Toggle on/off progressive loading.
+     *
+     * When a requested image is not in cache, a low resolution proxy is returned instead,
+     * from the cache or from a dedicated fast decode, until the requested image is loaded.
+     *
+     * @param[in] progressive new value for progressive loading flag
+     */
+    void setProgressive(bool progressive);
+
+    /// Check if progressive loading is enabled.
+    bool getProgressive() const { return _progressive; }
+
+    /**
+     * @brief Set the number of worker threads decoding images in parallel during prefetching.
+     * @param[in] nbThreads number of decoding threads (at least 1)
+     */
+    void setPrefetchingThreads(int nbThreads);
+
+    /// Get the number of worker threads decoding images in parallel during prefetching.
+    int getPrefetchingThreads() const { return _prefetchingThreads; }
+
     /**
      * @brief Set the target size for the images in the sequence.
      * @param[in] size target size
@@ -85,12 +255,59 @@ class SequenceCache : public QObject, public ImageServer
     void setTargetSize(int size);
 
     /**
-     * @brief Get the frames in the sequence that are currently cached.
+     * @brief Get the frames in the sequence that are currently cached at their target resolution.
      * @return a list of intervals, each one describing a range of cached frames
      * @note we use QPoints to represent the intervals (x: range start, y: range end)
+     * @note intervals are maintained as images are inserted in and evicted from cache, this is linear in the number of intervals
      */
     QVariantList getCachedFrames() const;
 
+    /// Get the number of frames in the sequence.
+    int getNbFrames() const { return static_cast<int>(_sequence.size()); }
+
+    /**
+     * @brief Get the filepath of a frame.
+     * @param[in] frame frame number in the sequence
+     * @return the filepath of the frame, or an empty string if the frame is not in the sequence
+     */
+    std::string getFramePath(int frame) const;
+
+    /**
+     * @brief Retrieve frame number corresponding to an image in the sequence.
+     * @param[in] path filepath of an image in the sequence
+     * @return frame number of the queried image if it is in the sequence, otherwise -1
+     */
+    int getFrame(const std::string& path) const;
+
+    /**
+     * @brief Check if a frame is available in cache at its target resolution.
+     * @param[in] frame frame number in the sequence
+     */
+    bool isCached(int frame) const;
+
+    /**
+     * @brief Get a percentile of the most recent decoding times of prefetched images.
+     * @param[in] p percentile, in [0, 100]
+     * @return decoding time, in milliseconds (0 if no image has been decoded)
+     */
+    double getDecodeLatency(double p) const { return _decodeLatencies->percentile(p); }
+
+    /// Forget the decoding times recorded so far.
+    void clearDecodeLatencies() { _decodeLatencies->clear(); }
+
+  public:
+    // Eviction advisory for the shared image cache (called from any thread)
+
+    double evictionDistance(const std::string& path) const override;
+
+    bool isPinned(const std::string& path) const override;
+
+    void onImageInserted(const std::string& path, int downscale) override;
+
+    void onImageEvicted(const std::string& path, int downscale) override;
+
+    void onCapacityChanged(uint64_t capacity) override;
+
   public:
     // Request management
 
@@ -98,6 +315,15 @@ class SequenceCache : public QObject, public ImageServer
     /// this method will launch a worker thread to prefetch new images from disk.
     ResponseData request(const RequestData& reqData) override;
 
+    /**
+     * @brief Slot called every time a frame's metadata has been retrieved by the metadata scan.
+     * @param[in] sequenceId the sequenceId initially used when the scan was started
+     * @param[in] frame the frame that has been probed
+     * @param[in] dim original image dimensions (empty if metadata could not be read)
+     * @param[in] metadata image metadata
+     */
+    Q_SLOT void onFrameProbed(int sequenceId, int frame, QSize dim, QVariantMap metadata);
+
     /**
      * @brief Slot called every time the prefetching thread progressed.
      * @param[in] reqFrame the frame initially requested when the worker thread was started
@@ -111,6 +337,12 @@ class SequenceCache : public QObject, public ImageServer
      */
     Q_SLOT void onPrefetchingDone(int sequenceId, int reqFrame);
 
+    /**
+     * @brief Slot called when a proxy image has been loaded.
+     * @param[in] sequenceId the sequenceId initially used when the worker thread was started
+     */
+    Q_SLOT void onProxyLoaded(int sequenceId);
+
     /**
      * @brief Signal emitted when the prefetching thread is done and a previous request has been handled.
      */
@@ -121,57 +353,237 @@ class SequenceCache : public QObject, public ImageServer
      */
     Q_SIGNAL void contentChanged();
 
+    /**
+     * @brief Signal emitted when the memory budget of the shared image cache has changed, by this or another client.
+     */
+    Q_SIGNAL void cacheCapacityChanged();
+
   private:
     // Member variables
 
     /// Ordered sequence of frames.
     std::vector<FrameData> _sequence;
 
-    /// Image cache.
-    aliceVision::image::ImageCache* _cache;
+    /// Index from filepath to frame number, rebuilt every time the sequence changes.
+    /// Only replaced from the main thread, with the eviction mutex locked.
+    std::shared_ptr<const std::unordered_map<std::string, int>> _frameIndex;
+
+    /// Loading order around the last requested frame, used as eviction distance.
+    PrefetchOrder _playhead;
+
+    /// Filepaths of the frames pinned in cache.
+    std::unordered_set<std::string> _pinnedPaths;
+
+    /// Mutex protecting eviction advisory state and cached frames from concurrent access by the shared image cache.
+    mutable std::mutex _evictionMutex;
+
+    /// Downscale levels (log2 of downscale factors) at which each frame is in the shared image cache, as bit masks.
+    std::vector<uint32_t> _cachedLevels;
+
+    /// Downscale level at which each frame is loaded, -1 if its metadata has not been retrieved yet.
+    std::vector<int> _targetLevels;
+
+    /// Ranges of consecutive frames in cache at their target downscale, from first to last frame (included).
+    std::map<int, int> _cachedIntervals;
+
+    /// Snapshot of the sequence for prefetching jobs, reset when the sequence or downscales change.
+    /// Published snapshots are never modified: frames probed afterwards only mark it as outdated.
+    SequenceSnapshot _snapshot;
+
+    /// Frames have been probed since the snapshot was built.
+    bool _snapshotOutdated = false;
+
+    /// Timer used to throttle snapshot rebuilds during the metadata scan.
+    QElapsedTimer _snapshotTimer;
+
+    /// Image cache, shared with other viewers.
+    std::shared_ptr<SharedImageCache> _cache;
 
     /// Frame interval used to decide if a prefetching thread should be launched.
     std::pair<int, int> _regionSafe;
 
-    /// Keep track of whether or not there is an active worker thread.
+    /// Keep track of whether or not there is an active prefetching job.
     bool _loading;
 
+    /// Active prefetching job, also used as its cancellation token.
+    std::shared_ptr<PrefetchingJob> _prefetchingJob;
+
     /// Allow main thread to abort the prefetching thread and restart a centered around a more accurate location
     bool _interactivePrefetching;
 
     /// Target size used to compute downscale
     int _targetSize;
 
+    /// Maximum dimension of loaded images (e.g. the maximum texture size of the viewer), 0 if unbounded
+    int _maxSize = 0;
+
+    /// Strategy deciding which frames are prefetched around requests.
+    std::unique_ptr<PrefetchPolicy> _prefetchPolicy;
+
     /// Local threadpool
     QThreadPool _threadPool;
 
+    /// Number of worker threads used for prefetching
+    int _prefetchingThreads;
+
     /// Current sequence id
     QAtomicInt _sequenceId;
 
     /// sequence mutex
     QMutex _lockSequence;
 
+    /// Threadpool dedicated to reading frame metadata
+    QThreadPool _metadataThreadPool;
+
+    /// Metadata scan of the current sequence
+    std::shared_ptr<MetadataScan> _metadataScan;
+
+    /// Number of frames of the current sequence whose metadata has not been retrieved yet
+    int _nbFramesToProbe;
+
+    /// Timer used to throttle contentChanged notifications during the metadata scan
+    QElapsedTimer _probeTimer;
+
+    /// Return low resolution proxies for images that are not in cache
+    bool _progressive = false;
+
+    /// Decoding times of prefetched images, recorded by worker threads.
+    std::shared_ptr<DecodeLatencies> _decodeLatencies;
+
   private:
     // Utility methods
 
     /**
-     * @brief Retrieve frame number corresponding to an image in the sequence.
-     * @param[in] path filepath of an image in the sequence
-     * @return frame number of the queried image if it is in the sequence, otherwise -1
+     * @brief Load a proxy of an image in a worker thread, replacing proxies that are still queued.
+     * @param[in] path image filepath
+     * @param[in] downscale downscale factor of the proxy
      */
-    int getFrame(const std::string& path) const;
+    void loadProxy(const std::string& path, int downscale);
+
+    /**
+     * @brief Compute the downscale to apply to an image for it to fit the target size and the maximum size.
+     * @param[in] dim original image dimensions
+     * @return a power of two downscale factor
+     */
+    int computeDownscale(const QSize& dim) const;
+
+    /**
+     * @brief Add or remove a frame from cached intervals, depending on the downscale levels at which it is in cache.
+     * @note must be called with the eviction mutex locked
+     * @param[in] frame frame number in the sequence
+     */
+    void updateCachedIntervals(int frame);
+
+    /**
+     * @brief Update the downscale of all probed frames, resetting prefetching state if any has changed.
+     * @return true if the downscale of at least one frame has changed, otherwise false
+     */
+    bool updateDownscales();
+
+    /**
+     * @brief Get a snapshot of the current sequence, building it if the sequence has changed.
+     * @note during the metadata scan, outdated snapshots are rebuilt at most a few times per second:
+     *       frames probed meanwhile are only prefetched by later jobs
+     * @return an immutable view of the sequence
+     */
+    SequenceSnapshot getSnapshot();
+};
+
+/**
+ * @brief Utility class for retrieving frame metadata from disk asynchronously.
+ *
+ * Several instances share the same MetadataScan and pull frames from it in sequence order,
+ * so that frames become available to clients progressively.
+ */
+class MetadataIORunnable : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+  public:
+    /**
+     * @param[in] scan shared state of the metadata scan
+     * @param[in] sequenceId sequenceId to memorize
+     */
+    MetadataIORunnable(const std::shared_ptr<MetadataScan>& scan, int sequenceId);
+
+    ~MetadataIORunnable();
+
+    /// Main method for reading frame metadata in a worker thread.
+    Q_SLOT void run() override;
+
+    /**
+     * @brief Signal emitted every time a frame has been probed.
+     * @param[in] sequenceId sequenceId at the time of launch
+     * @param[in] frame the frame that has been probed
+     * @param[in] dim original image dimensions (empty if metadata could not be read)
+     * @param[in] metadata image metadata
+     */
+    Q_SIGNAL void probed(int sequenceId, int frame, QSize dim, QVariantMap metadata);
+
+  private:
+    /// Shared state of the metadata scan.
+    std::shared_ptr<MetadataScan> _scan;
+
+    /// Sequence id
+    int _sequenceId;
+};
+
+/**
+ * @brief Shared state of a prefetching job, split between several worker threads.
+ */
+struct PrefetchingJob
+{
+    /// Sequence to load frames from.
+    SequenceSnapshot sequence;
+
+    /// Loading order around the initially requested frame.
+    PrefetchOrder order;
+
+    /// Maximum memory that can be filled.
+    uint64_t toFill = 0;
+
+    /// Memory used per pixel by loaded images, depending on the cache storage mode.
+    uint64_t bytesPerPixel = 16;
+
+    /// Next frame to load after the requested frame.
+    int forward = 0;
+
+    /// Next frame to load before the requested frame.
+    int backward = -1;
+
+    /// Mutex protecting frame cursors.
+    std::mutex mutex;
+
+    /// Cache capacity reserved by workers for loaded images.
+    std::atomic<uint64_t> filled = 0;
+
+    /// Number of workers still running.
+    std::atomic_int nbRunning = 0;
+
+    /// Flag for stopping all workers, set by the owning SequenceCache to cancel the job or by workers when cache capacity is reached.
+    std::atomic_bool stop = false;
+
+    /// Time of the last progress signal, in milliseconds.
+    std::atomic<int64_t> lastProgress = 0;
+
+    /// Decoding times of loaded images, shared with the owning SequenceCache.
+    std::shared_ptr<DecodeLatencies> latencies;
 
     /**
-     * @brief Build a frame interval in the sequence.
-     * @param[in] frame central frame of the interval
-     * @param[in] extent interval half-size
-     * @return an interval of size 2*extent that fits in the sequence and contains the given frame
+     * @brief Get the next frame to load in loading order.
+     * @return a frame number, or -1 if all frames have been handed out
      */
-    std::pair<int, int> buildRegion(int frame, int extent) const;
+    int pull();
+
+    /// Current time in milliseconds, from a monotonic clock.
+    static int64_t now();
 };
 
 /**
  * @brief Utility class for loading images from disk to cache asynchronously.
+ *
+ * Several instances share the same PrefetchingJob and pull frames from it by distance to the requested frame,
+ * so that images are decoded in parallel and each frame is loaded by a single worker.
  */
 class PrefetchingIORunnable : public QObject, public QRunnable
 {
@@ -180,16 +592,10 @@ class PrefetchingIORunnable : public QObject, public QRunnable
   public:
     /**
      * @param[in] cache pointer to image cache to fill
-     * @param[in] toLoad sequence frames to load from disk
-     * @param[in] reqFrame initially requested frame
-     * @param[in] fillRatio proportion of cache capacity that can be filled
-     * @param[in] sequenceId sequenceId to memorize
+     * @param[in] job shared state of the prefetching job
+     * @param[in] sequenceId sequenceId to memorize
      */
-    PrefetchingIORunnable(aliceVision::image::ImageCache* cache,
-                          const std::vector<FrameData>& toLoad,
-                          int reqFrame,
-                          double fillRatio,
-                          int sequenceId);
+    PrefetchingIORunnable(const std::shared_ptr<SharedImageCache>& cache, const std::shared_ptr<PrefetchingJob>& job, int sequenceId);
 
     ~PrefetchingIORunnable();
 
@@ -203,7 +609,7 @@ class PrefetchingIORunnable : public QObject, public QRunnable
     Q_SIGNAL void progressed(int reqFrame);
 
     /**
-     * @brief Signal emitted when prefetching is finished.
+     * @brief Signal emitted when prefetching is finished (by the last worker of the job).
      * @param[in] sequenceId sequenceId at the time of launch
      * @param[in] reqFrame initially requested frame
      */
@@ -211,16 +617,54 @@ class PrefetchingIORunnable : public QObject, public QRunnable
 
   private:
     /// Image cache to fill.
-    aliceVision::image::ImageCache* _cache;
+    std::shared_ptr<SharedImageCache> _cache;
 
-    /// Frames to load in cache.
-    std::vector<FrameData> _toLoad;
+    /// Shared state of the prefetching job.
+    std::shared_ptr<PrefetchingJob> _job;
 
     /// Initially requested frame, used as central point for loading order.
     int _reqFrame;
 
-    /// Maximum memory that can be filled.
-    uint64_t _toFill;
+    /// Sequence id
+    int _sequenceId;
+};
+
+/**
+ * @brief Utility class for loading a low resolution proxy image to cache asynchronously.
+ */
+class ProxyIORunnable : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+  public:
+    /**
+     * @param[in] cache pointer to image cache to fill
+     * @param[in] path filepath of the image
+     * @param[in] downscale downscale factor of the proxy
+     * @param[in] sequenceId sequenceId to memorize
+     */
+    ProxyIORunnable(const std::shared_ptr<SharedImageCache>& cache, const std::string& path, int downscale, int sequenceId);
+
+    ~ProxyIORunnable();
+
+    /// Main method for loading the proxy in a worker thread.
+    Q_SLOT void run() override;
+
+    /**
+     * @brief Signal emitted when the proxy has been loaded in cache (not emitted if loading failed).
+     * @param[in] sequenceId sequenceId at the time of launch
+     */
+    Q_SIGNAL void loaded(int sequenceId);
+
+  private:
+    /// Image cache to fill.
+    std::shared_ptr<SharedImageCache> _cache;
+
+    /// Filepath of the image.
+    std::string _path;
+
+    /// Downscale factor of the proxy.
+    int _downscale;
 
     /// Sequence id
     int _sequenceId;
@@ -2,6 +2,8 @@
 
 #include <memory>
 
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
 #include <QSGGeometry>
 #include <QSGGeometryNode>
 #include <QSGSimpleMaterial>
@@ -19,8 +21,34 @@ struct ShaderData
     float aspectRatio = 0.f;
     QVector4D channelOrder = QVector4D(0, 1, 2, 3);
     std::unique_ptr<QSGTexture> texture;
+
+    /// Exposure adjustment, in stops.
+    float exposure = 0.f;
+
+    /// Display mode: 0 for the image, 1 for false color exposure zones, 2 for zebra stripes over clipped pixels.
+    float displayMode = 0.f;
+
+    /// Display value above which zebra stripes are drawn.
+    float zebraThreshold = 0.95f;
+
+    /// 3D lookup table replacing the gamma and sRGB display transform, packed in a 2D texture (shared with tiles).
+    std::shared_ptr<QSGTexture> lut;
+    float lutSize = 0.f;
+    QVector3D lutDomainMin = QVector3D(0, 0, 0);
+    QVector3D lutDomainMax = QVector3D(1, 1, 1);
 };
 
+/**
+ * @brief Display transform applied to every fragment, in this order:
+ *  - gain and exposure in scene-linear values,
+ *  - false color zones computed from scene-linear luminance (if enabled),
+ *  - 3D lookup table (if any), otherwise gamma and sRGB encoding,
+ *  - zebra stripes over display values above the threshold (if enabled),
+ *  - channel selection.
+ * All stages are driven by uniforms in a single program compiled once:
+ * changing the view transform or toggling a mode never recompiles shaders nor reloads the image.
+ */
+
 class ImageViewerShader : public QSGSimpleMaterialShader<ShaderData>
 {
     QSG_DECLARE_SIMPLE_SHADER(ImageViewerShader, ShaderData)
@@ -48,10 +76,42 @@ class ImageViewerShader : public QSGSimpleMaterialShader<ShaderData>
                "uniform float fisheyeCircleRadius;                                              \n"
                "uniform float aspectRatio;                                                      \n"
                "uniform vec4 channelOrder;                                                      \n"
+               "uniform highp float exposure;                                                   \n"
+               "uniform float displayMode;                                                      \n"
+               "uniform highp float zebraThreshold;                                             \n"
+               "uniform highp sampler2D lut;                                                    \n"
+               "uniform highp float lutSize;                                                    \n"
+               "uniform highp vec3 lutDomainMin;                                                \n"
+               "uniform highp vec3 lutDomainMax;                                                \n"
                "varying highp vec2 vTexCoord;                                                   \n"
+               "highp vec3 applyLut(highp vec3 rgb) {                                           \n"
+               "    highp vec3 x = clamp((rgb - lutDomainMin) / (lutDomainMax - lutDomainMin), 0.0, 1.0) * (lutSize - 1.0); \n"
+               "    highp float slice = floor(x.b);                                             \n"
+               "    highp float nextSlice = min(slice + 1.0, lutSize - 1.0);                    \n"
+               "    highp vec2 uv = vec2((x.r + 0.5) / (lutSize * lutSize), (x.g + 0.5) / lutSize); \n"
+               "    highp vec3 c0 = texture2D(lut, uv + vec2(slice / lutSize, 0.0)).rgb;        \n"
+               "    highp vec3 c1 = texture2D(lut, uv + vec2(nextSlice / lutSize, 0.0)).rgb;    \n"
+               "    return mix(c0, c1, x.b - slice);                                            \n"
+               "}                                                                               \n"
+               "highp vec3 falseColor(highp vec3 rgb) {                                         \n"
+               "    highp float luminance = dot(rgb, vec3(0.2126, 0.7152, 0.0722));             \n"
+               "    highp float stops = log2(max(luminance, 1e-6) / 0.18);                      \n"
+               "    highp float hue = (1.0 - clamp((stops + 6.0) / 12.0, 0.0, 1.0)) * 0.6667;   \n"
+               "    return clamp(vec3(abs(hue * 6.0 - 3.0) - 1.0, 2.0 - abs(hue * 6.0 - 2.0), 2.0 - abs(hue * 6.0 - 4.0)), 0.0, 1.0); \n"
+               "}                                                                               \n"
                "void main() {                                                                   \n"
                "    vec4 color = texture2D(texture, vTexCoord);                                 \n"
-               "    color.rgb = pow(pow((color.rgb * vec3(gain)), vec3(1.0/gamma)), vec3(1.0 / 2.2)); \n"
+               "    color.rgb *= gain * exp2(exposure);                                         \n"
+               "    if (displayMode > 0.5 && displayMode < 1.5) {                               \n"
+               "        color.rgb = falseColor(color.rgb);                                      \n"
+               "    } else if (lutSize > 1.0) {                                                 \n"
+               "        color.rgb = applyLut(color.rgb);                                        \n"
+               "    } else {                                                                    \n"
+               "        color.rgb = pow(pow(color.rgb, vec3(1.0/gamma)), vec3(1.0 / 2.2));      \n"
+               "    }                                                                           \n"
+               "    if (displayMode > 1.5 && max(color.r, max(color.g, color.b)) >= zebraThreshold) { \n"
+               "        color.rgb = mod(gl_FragCoord.x + gl_FragCoord.y, 16.0) < 8.0 ? vec3(0.0) : vec3(1.0); \n"
+               "    }                                                                           \n"
                "    gl_FragColor.r = color[int(channelOrder[0])];                               \n"
                "    gl_FragColor.g = color[int(channelOrder[1])];                               \n"
                "    gl_FragColor.b = color[int(channelOrder[2])];                               \n"
@@ -81,6 +141,22 @@ class ImageViewerShader : public QSGSimpleMaterialShader<ShaderData>
         program()->setUniformValue(_fisheyeCircleRadiusId, data->fisheyeCircleRadius);
         program()->setUniformValue(_aspectRatio, data->aspectRatio);
 
+        program()->setUniformValue(_exposureId, data->exposure);
+        program()->setUniformValue(_displayModeId, data->displayMode);
+        program()->setUniformValue(_zebraThresholdId, data->zebraThreshold);
+        program()->setUniformValue(_lutSizeId, data->lut ? data->lutSize : 0.f);
+        program()->setUniformValue(_lutDomainMinId, data->lutDomainMin);
+        program()->setUniformValue(_lutDomainMaxId, data->lutDomainMax);
+
+        // The lookup table uses texture unit 1
+        if (data->lut)
+        {
+            QOpenGLFunctions* funcs = QOpenGLContext::currentContext()->functions();
+            funcs->glActiveTexture(GL_TEXTURE1);
+            data->lut->bind();
+            funcs->glActiveTexture(GL_TEXTURE0);
+        }
+
         if (data->texture)
         {
             data->texture->bind();
@@ -96,9 +172,17 @@ class ImageViewerShader : public QSGSimpleMaterialShader<ShaderData>
         _fisheyeCircleRadiusId = program()->uniformLocation("fisheyeCircleRadius");
         _aspectRatio = program()->uniformLocation("aspectRatio");
         _channelOrder = program()->uniformLocation("channelOrder");
+        _exposureId = program()->uniformLocation("exposure");
+        _displayModeId = program()->uniformLocation("displayMode");
+        _zebraThresholdId = program()->uniformLocation("zebraThreshold");
+        _lutId = program()->uniformLocation("lut");
+        _lutSizeId = program()->uniformLocation("lutSize");
+        _lutDomainMinId = program()->uniformLocation("lutDomainMin");
+        _lutDomainMaxId = program()->uniformLocation("lutDomainMax");
 
-        // We will only use texture unit 0, so set it only once.
+        // Texture units are fixed (0 for the image, 1 for the lookup table), so set them only once.
         program()->setUniformValue(_textureId, 0);
+        program()->setUniformValue(_lutId, 1);
     }
 
   private:
@@ -109,6 +193,13 @@ class ImageViewerShader : public QSGSimpleMaterialShader<ShaderData>
     int _fisheyeCircleCoordId = -1;
     int _fisheyeCircleRadiusId = -1;
     int _aspectRatio = -1;
+    int _exposureId = -1;
+    int _displayModeId = -1;
+    int _zebraThresholdId = -1;
+    int _lutId = -1;
+    int _lutSizeId = -1;
+    int _lutDomainMinId = -1;
+    int _lutDomainMaxId = -1;
 };
 
 }  // namespace
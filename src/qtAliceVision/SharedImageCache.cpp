@@ -0,0 +1,527 @@
+#include "SharedImageCache.hpp"
+#include "IOScheduler.hpp"
+#include "ImageDecoder.hpp"
+#include "ProxyStore.hpp"
+
+#include <aliceVision/system/MemoryInfo.hpp>
+
+#include <QRunnable>
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <limits>
+
+namespace qtAliceVision {
+namespace imgserve {
+
+namespace {
+
+/**
+ * @brief Runnable writing a decoded image to the persistent proxy store, off the path of clients waiting for it.
+ */
+class ProxyWriteRunnable : public QRunnable
+{
+  public:
+    ProxyWriteRunnable(const std::string& path, int downscale, const CachedImage& img)
+      : _path(path),
+        _downscale(downscale),
+        _img(img)
+    {}
+
+    void run() override
+    {
+        // Cached images are never modified, they can be read while shared with clients
+        if (_img.halfImg)
+        {
+            ProxyStore::instance().write(_path, _downscale, *_img.halfImg);
+        }
+        else if (_img.img)
+        {
+            ProxyStore::instance().write(_path, _downscale, HalfImage(*_img.img));
+        }
+    }
+
+  private:
+    std::string _path;
+    int _downscale;
+    CachedImage _img;
+};
+
+}  // namespace
+
+uint64_t CachedImage::memorySize() const
+{
+    if (halfImg)
+    {
+        return halfImg->memorySize();
+    }
+    if (img)
+    {
+        return static_cast<uint64_t>(img->Width()) * static_cast<uint64_t>(img->Height()) * sizeof(aliceVision::image::RGBAfColor);
+    }
+    return 0;
+}
+
+std::shared_ptr<SharedImageCache> SharedImageCache::acquire()
+{
+    static std::mutex instanceMutex;
+    static std::weak_ptr<SharedImageCache> instance;
+
+    std::lock_guard<std::mutex> lock(instanceMutex);
+
+    std::shared_ptr<SharedImageCache> cache = instance.lock();
+    if (!cache)
+    {
+        // Retrieve memory information from system
+        const auto memInfo = aliceVision::system::getMemoryInfo();
+
+        // Compute proportion of RAM that can be dedicated to image caching
+        // For now we use 30% of available RAM, for all viewers together
+        const double availableRam = static_cast<double>(memInfo.availableRam);
+        const double cacheRatio = 0.3;
+        const uint64_t cacheRam = static_cast<uint64_t>(cacheRatio * availableRam);
+
+        cache = std::shared_ptr<SharedImageCache>(new SharedImageCache(cacheRam, cacheRatio));
+        instance = cache;
+    }
+
+    return cache;
+}
+
+SharedImageCache::SharedImageCache(uint64_t capacity, double capacityRatio)
+  : _capacity(capacity),
+    _capacityRatio(capacityRatio)
+{}
+
+SharedImageCache::~SharedImageCache() {}
+
+CachedImage SharedImageCache::get(const std::string& path, int downscale)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    const auto it = _entries.find(Key{path, downscale});
+    if (it == _entries.end())
+    {
+        return CachedImage();
+    }
+
+    // Mark image as most recently used
+    _lru.splice(_lru.begin(), _lru, it->second.lruIt);
+
+    return it->second.img;
+}
+
+CachedImage SharedImageCache::getCoarser(const std::string& path, int downscale, int maxDownscale)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (int level = downscale * 2; level <= maxDownscale; level *= 2)
+    {
+        const auto it = _entries.find(Key{path, level});
+        if (it != _entries.end())
+        {
+            _lru.splice(_lru.begin(), _lru, it->second.lruIt);
+            return it->second.img;
+        }
+    }
+
+    return CachedImage();
+}
+
+CachedImage SharedImageCache::load(const std::string& path, int downscale)
+{
+    const Key key{path, downscale};
+
+    std::promise<CachedImage> promise;
+    std::shared_future<CachedImage> future;
+    bool isLoader = false;
+    EStorageMode storageMode;
+    bool persistent;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        // Image is already in cache
+        const auto it = _entries.find(key);
+        if (it != _entries.end())
+        {
+            _lru.splice(_lru.begin(), _lru, it->second.lruIt);
+            return it->second.img;
+        }
+
+        // Image is being loaded by another thread
+        const auto pendingIt = _pending.find(key);
+        if (pendingIt != _pending.end())
+        {
+            future = pendingIt->second;
+        }
+        else
+        {
+            future = promise.get_future().share();
+            _pending.emplace(key, future);
+            isLoader = true;
+        }
+
+        storageMode = _storageMode;
+        persistent = _persistent;
+    }
+
+    // Wait for the other thread (rethrows its error if loading failed)
+    if (!isLoader)
+    {
+        return future.get();
+    }
+
+    // Load image from disk, without holding the cache mutex
+    CachedImage img;
+    bool storeProxy = false;
+    try
+    {
+        // Downscaled images can be read back from the persistent proxy store instead of being decoded
+        const bool useStore = persistent && downscale > 1;
+        auto storedImg = std::make_shared<HalfImage>();
+        if (useStore && ProxyStore::instance().read(path, downscale, *storedImg))
+        {
+            // Half float proxies stay mapped from the store file, without any copy
+            if (storageMode == EStorageMode::Half)
+            {
+                img.halfImg = storedImg;
+            }
+            else
+            {
+                img.img = std::make_shared<Image>();
+                storedImg->toFloat(*img.img);
+                img.bytesCopied = img.memorySize();
+            }
+        }
+        else
+        {
+            // Decode directly at the downscaled resolution when the file allows it
+            img.img = std::make_shared<Image>();
+            img.bytesCopied = decodeImage(path, downscale, *img.img);
+
+            // Convert to storage precision, releasing the full precision image
+            if (storageMode == EStorageMode::Half)
+            {
+                img.halfImg = std::make_shared<HalfImage>(*img.img);
+                img.img.reset();
+                img.bytesCopied += img.halfImg->memorySize();
+            }
+
+            // Fill the persistent proxy store for next sessions, once the image has been delivered
+            storeProxy = useStore;
+        }
+    }
+    catch (...)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pending.erase(key);
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        insert(key, img);
+        _pending.erase(key);
+    }
+    promise.set_value(img);
+
+    // Writing the proxy (and converting it to half float) is deferred to a background task:
+    // clients waiting for the image are not delayed by disk writes
+    if (storeProxy)
+    {
+        IOScheduler::instance().start(IOScheduler::EIOClass::Background, new ProxyWriteRunnable(path, downscale, img));
+    }
+
+    return img;
+}
+
+bool SharedImageCache::contains(const std::string& path, int downscale) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _entries.find(Key{path, downscale}) != _entries.end();
+}
+
+uint64_t SharedImageCache::getCapacity() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _capacity;
+}
+
+uint64_t SharedImageCache::getMemoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _memoryUsage;
+}
+
+void SharedImageCache::setCapacity(uint64_t capacity)
+{
+    const auto memInfo = aliceVision::system::getMemoryInfo();
+    const double availableRam = static_cast<double>(memInfo.availableRam);
+    updateCapacity(capacity, (availableRam > 0.) ? std::min(1., static_cast<double>(capacity) / availableRam) : 0.);
+}
+
+void SharedImageCache::setCapacityRatio(double ratio)
+{
+    const auto memInfo = aliceVision::system::getMemoryInfo();
+    const double availableRam = static_cast<double>(memInfo.availableRam);
+    const double clampedRatio = std::clamp(ratio, 0., 1.);
+    updateCapacity(static_cast<uint64_t>(clampedRatio * availableRam), clampedRatio);
+}
+
+double SharedImageCache::getCapacityRatio() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _capacityRatio;
+}
+
+void SharedImageCache::updateCapacity(uint64_t capacity, double capacityRatio)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (capacity == _capacity && capacityRatio == _capacityRatio)
+    {
+        return;
+    }
+
+    _capacity = capacity;
+    _capacityRatio = capacityRatio;
+    shrink(0);
+
+    // All clients share the budget, whichever one changed it
+    for (EvictionAdvisor* advisor : _advisors)
+    {
+        advisor->onCapacityChanged(_capacity);
+    }
+}
+
+EEvictionPolicy SharedImageCache::getEvictionPolicy() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _evictionPolicy;
+}
+
+void SharedImageCache::setEvictionPolicy(EEvictionPolicy policy)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _evictionPolicy = policy;
+}
+
+EStorageMode SharedImageCache::getStorageMode() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _storageMode;
+}
+
+void SharedImageCache::setStorageMode(EStorageMode mode)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _storageMode = mode;
+}
+
+bool SharedImageCache::isPersistent() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _persistent;
+}
+
+void SharedImageCache::setPersistent(bool persistent)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _persistent = persistent;
+}
+
+uint64_t SharedImageCache::getBytesPerPixel() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return (_storageMode == EStorageMode::Half) ? 4 * sizeof(uint16_t) : sizeof(aliceVision::image::RGBAfColor);
+}
+
+void SharedImageCache::addClient(EvictionAdvisor* advisor)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _advisors.push_back(advisor);
+}
+
+void SharedImageCache::removeClient(EvictionAdvisor* advisor)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _advisors.erase(std::remove(_advisors.begin(), _advisors.end(), advisor), _advisors.end());
+}
+
+void SharedImageCache::notifyContent(EvictionAdvisor* advisor) const
+{
+    // Cache content cannot change until the client has been notified of every image
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const auto& entry : _entries)
+    {
+        advisor->onImageInserted(entry.first.path, entry.first.downscale);
+    }
+}
+
+int SharedImageCache::getNbClients() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return static_cast<int>(_advisors.size());
+}
+
+void SharedImageCache::insert(const Key& key, const CachedImage& img)
+{
+    const uint64_t size = img.memorySize();
+
+    // Image does not fit in cache at all
+    if (size > _capacity)
+    {
+        return;
+    }
+
+    // Evict images until the new one fits
+    shrink(size);
+
+    _lru.push_front(key);
+    _entries[key] = Entry{img, size, _lru.begin()};
+    _memoryUsage += size;
+
+    for (EvictionAdvisor* advisor : _advisors)
+    {
+        advisor->onImageInserted(key.path, key.downscale);
+    }
+}
+
+void SharedImageCache::evict(const Key& key)
+{
+    const auto it = _entries.find(key);
+    if (it == _entries.end())
+    {
+        return;
+    }
+
+    for (EvictionAdvisor* advisor : _advisors)
+    {
+        advisor->onImageEvicted(key.path, key.downscale);
+    }
+
+    _memoryUsage -= it->second.size;
+    _lru.erase(it->second.lruIt);
+    _entries.erase(it);
+}
+
+void SharedImageCache::shrink(uint64_t toFit)
+{
+    if (_memoryUsage + toFit <= _capacity)
+    {
+        return;
+    }
+
+    // Policies querying advisors scan the whole cache: evict in batches, down to a low-water mark below the budget,
+    // so that scans happen once per batch instead of once per inserted image
+    const uint64_t headroom = (_evictionPolicy == EEvictionPolicy::LRU) ? 0 : std::min(_capacity / 20, _capacity - std::min(toFit, _capacity));
+
+    // Evicted images remain valid for clients that still hold them
+    for (const Key& victim : selectVictims(toFit + headroom))
+    {
+        evict(victim);
+    }
+}
+
+std::vector<SharedImageCache::Key> SharedImageCache::selectVictims(uint64_t toFit) const
+{
+    std::vector<Key> victims;
+    uint64_t freed = 0;
+    auto fits = [this, toFit, &freed]() { return _memoryUsage - freed + toFit <= _capacity; };
+    auto addVictim = [this, &victims, &freed](const Key& key) {
+        victims.push_back(key);
+        freed += _entries.at(key).size;
+    };
+
+    switch (_evictionPolicy)
+    {
+        case EEvictionPolicy::Distance:
+        {
+            // Evict images unused by all clients first, by recency of use
+            // Other images are sorted once by decreasing distance to the closest client, ties broken by recency of use
+            struct Candidate
+            {
+                double distance;
+                std::size_t age;
+                const Key* key;
+            };
+            std::vector<Candidate> candidates;
+            std::size_t age = 0;
+            for (auto it = _lru.rbegin(); it != _lru.rend(); ++it, ++age)
+            {
+                double distance = std::numeric_limits<double>::infinity();
+                for (const EvictionAdvisor* advisor : _advisors)
+                {
+                    const double clientDistance = advisor->evictionDistance(it->path);
+                    if (clientDistance >= 0.)
+                    {
+                        distance = std::min(distance, clientDistance);
+                    }
+                }
+
+                if (std::isinf(distance))
+                {
+                    addVictim(*it);
+                    if (fits())
+                    {
+                        return victims;
+                    }
+                }
+                else
+                {
+                    candidates.push_back({distance, age, &*it});
+                }
+            }
+
+            std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+                return (a.distance != b.distance) ? a.distance > b.distance : a.age < b.age;
+            });
+            for (std::size_t i = 0; i < candidates.size() && !fits(); ++i)
+            {
+                addVictim(*candidates[i].key);
+            }
+            return victims;
+        }
+        case EEvictionPolicy::Keyframes:
+        {
+            // Evict the least recently used images that no client pinned
+            std::vector<const Key*> pinnedKeys;
+            for (auto it = _lru.rbegin(); it != _lru.rend() && !fits(); ++it)
+            {
+                const bool pinned = std::any_of(
+                  _advisors.begin(), _advisors.end(), [&it](const EvictionAdvisor* advisor) { return advisor->isPinned(it->path); });
+                if (pinned)
+                {
+                    pinnedKeys.push_back(&*it);
+                }
+                else
+                {
+                    addVictim(*it);
+                }
+            }
+
+            // Only pinned images left: the budget prevails
+            for (std::size_t i = 0; i < pinnedKeys.size() && !fits(); ++i)
+            {
+                addVictim(*pinnedKeys[i]);
+            }
+            return victims;
+        }
+        case EEvictionPolicy::LRU:
+        default:
+        {
+            for (auto it = _lru.rbegin(); it != _lru.rend() && !fits(); ++it)
+            {
+                addVictim(*it);
+            }
+            return victims;
+        }
+    }
+}
+
+}  // namespace imgserve
+}  // namespace qtAliceVision
@@ -0,0 +1,333 @@
+#pragma once
+
+#include "HalfImage.hpp"
+
+#include <aliceVision/image/all.hpp>
+
+#include <cstdint>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace qtAliceVision {
+namespace imgserve {
+
+/**
+ * @brief Strategy used to choose which images to evict when the cache budget is exceeded.
+ */
+enum class EEvictionPolicy
+{
+    /// Least recently used images first.
+    LRU,
+    /// Images farthest from every client's current position first.
+    Distance,
+    /// Least recently used images first, keeping images pinned by clients (e.g. keyframes).
+    Keyframes
+};
+
+/**
+ * @brief Precision used to store decoded images in cache.
+ */
+enum class EStorageMode
+{
+    /// 32-bit float channels (16 bytes per pixel).
+    Float,
+    /// 16-bit float channels (8 bytes per pixel), enough for display.
+    Half
+};
+
+/**
+ * @brief Decoded image, in full or half float precision depending on the storage mode it was loaded with.
+ */
+struct CachedImage
+{
+    std::shared_ptr<aliceVision::image::Image<aliceVision::image::RGBAfColor>> img;
+
+    std::shared_ptr<HalfImage> halfImg;
+
+    /// Bytes copied in memory to produce the image after decoding (resampling, conversions).
+    uint64_t bytesCopied = 0;
+
+    explicit operator bool() const { return img || halfImg; }
+
+    /// Memory used by pixel data, in bytes.
+    uint64_t memorySize() const;
+};
+
+/**
+ * @brief Interface for clients of the SharedImageCache to steer eviction and follow cache content.
+ * @note methods are called from any thread with the cache locked, they must not call back into the cache
+ */
+class EvictionAdvisor
+{
+  public:
+    virtual ~EvictionAdvisor() = default;
+
+    /**
+     * @brief Get the distance of an image to the client's current position (used by the Distance policy).
+     * @param[in] path image filepath
+     * @return a non-negative distance, or a negative value if the client does not use the image
+     */
+    virtual double evictionDistance(const std::string& path) const = 0;
+
+    /**
+     * @brief Check if the client pinned an image (used by the Keyframes policy).
+     * @param[in] path image filepath
+     */
+    virtual bool isPinned(const std::string& path) const = 0;
+
+    /**
+     * @brief Called when an image has been inserted in cache.
+     * @param[in] path image filepath
+     * @param[in] downscale downscale factor
+     */
+    virtual void onImageInserted(const std::string& path, int downscale)
+    {
+        (void)path;
+        (void)downscale;
+    }
+
+    /**
+     * @brief Called when an image has been evicted from cache.
+     * @param[in] path image filepath
+     * @param[in] downscale downscale factor
+     */
+    virtual void onImageEvicted(const std::string& path, int downscale)
+    {
+        (void)path;
+        (void)downscale;
+    }
+
+    /**
+     * @brief Called when the memory budget of the cache has changed, whichever client changed it.
+     * @param[in] capacity new memory budget, in bytes
+     */
+    virtual void onCapacityChanged(uint64_t capacity) { (void)capacity; }
+};
+
+/**
+ * @brief Process-wide cache of decoded images, shared by all image servers.
+ *
+ * Images are identified by their filepath and downscale factor,
+ * so that viewers displaying the same sequence share decoded frames instead of loading them twice.
+ * All images count towards a single memory budget, which can be changed at any time,
+ * and the images to evict when it is exceeded are chosen according to the eviction policy.
+ * Images are converted at decode time to the storage mode of the cache:
+ * changing it does not affect images already in cache.
+ * Downscaled images can also be persisted on disk with the ProxyStore, to avoid decoding them again in later sessions.
+ *
+ * The cache is reference-counted: it is created by the first client and destroyed with the last one.
+ * All methods are thread-safe.
+ */
+class SharedImageCache
+{
+  public:
+    using Image = aliceVision::image::Image<aliceVision::image::RGBAfColor>;
+
+    /// Get the process-wide cache, creating it if there is none.
+    static std::shared_ptr<SharedImageCache> acquire();
+
+    ~SharedImageCache();
+
+    SharedImageCache(const SharedImageCache&) = delete;
+    SharedImageCache& operator=(const SharedImageCache&) = delete;
+
+    /**
+     * @brief Retrieve an image if it is in cache.
+     * @param[in] path image filepath
+     * @param[in] downscale downscale factor
+     * @return the cached image, or an empty one if it is not in cache
+     */
+    CachedImage get(const std::string& path, int downscale);
+
+    /**
+     * @brief Retrieve the most detailed version of an image that is in cache at a coarser resolution than requested.
+     * @param[in] path image filepath
+     * @param[in] downscale requested downscale factor
+     * @param[in] maxDownscale coarsest downscale factor to consider
+     * @return the cached image, or an empty one if there is none
+     */
+    CachedImage getCoarser(const std::string& path, int downscale, int maxDownscale);
+
+    /**
+     * @brief Retrieve an image, loading it from disk if it is not in cache.
+     * @note if the image is already being loaded by another thread, wait for it instead of loading it again
+     * @param[in] path image filepath
+     * @param[in] downscale downscale factor
+     * @return the image
+     * @throw std::runtime_error if the image cannot be read from disk
+     */
+    CachedImage load(const std::string& path, int downscale);
+
+    /**
+     * @brief Check if an image is in cache.
+     * @param[in] path image filepath
+     * @param[in] downscale downscale factor
+     */
+    bool contains(const std::string& path, int downscale) const;
+
+    /// Get the memory budget of the cache, in bytes.
+    uint64_t getCapacity() const;
+
+    /**
+     * @brief Set the memory budget of the cache, evicting images if needed.
+     * @param[in] capacity memory budget, in bytes
+     */
+    void setCapacity(uint64_t capacity);
+
+    /**
+     * @brief Set the memory budget of the cache as a proportion of currently available RAM.
+     * @param[in] ratio proportion of available RAM, in [0, 1]
+     */
+    void setCapacityRatio(double ratio);
+
+    /// Get the memory budget of the cache as a proportion of available RAM when it was set.
+    double getCapacityRatio() const;
+
+    /// Get the memory currently used by cached images, in bytes.
+    uint64_t getMemoryUsage() const;
+
+    /// Get the precision used to store newly decoded images.
+    EStorageMode getStorageMode() const;
+
+    /// Set the precision used to store newly decoded images.
+    void setStorageMode(EStorageMode mode);
+
+    /// Check if downscaled images are read from and written to the persistent proxy store.
+    bool isPersistent() const;
+
+    /**
+     * @brief Toggle on/off the persistent proxy store for downscaled images.
+     * @param[in] persistent new value for the persistent flag
+     */
+    void setPersistent(bool persistent);
+
+    /// Get the memory used per pixel by newly decoded images, in bytes.
+    uint64_t getBytesPerPixel() const;
+
+    /// Get the strategy used to choose which images to evict.
+    EEvictionPolicy getEvictionPolicy() const;
+
+    /// Set the strategy used to choose which images to evict.
+    void setEvictionPolicy(EEvictionPolicy policy);
+
+    /**
+     * @brief Register a client sharing the cache budget.
+     * @param[in] advisor client's eviction advisor, must stay valid until the client is unregistered
+     */
+    void addClient(EvictionAdvisor* advisor);
+
+    /// Unregister a client sharing the cache budget.
+    void removeClient(EvictionAdvisor* advisor);
+
+    /**
+     * @brief Notify a client of all images currently in cache, as if they had just been inserted.
+     * @note used by clients to initialize their view of cache content, before following insertions and evictions
+     * @param[in] advisor registered client's eviction advisor
+     */
+    void notifyContent(EvictionAdvisor* advisor) const;
+
+    /// Get the number of clients sharing the cache budget.
+    int getNbClients() const;
+
+  private:
+    /**
+     * @param[in] capacity memory budget, in bytes
+     * @param[in] capacityRatio memory budget as a proportion of available RAM
+     */
+    SharedImageCache(uint64_t capacity, double capacityRatio);
+
+    /// Cache entry identifier.
+    struct Key
+    {
+        std::string path;
+        int downscale;
+
+        bool operator==(const Key& other) const { return downscale == other.downscale && path == other.path; }
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& key) const { return std::hash<std::string>()(key.path) ^ (std::hash<int>()(key.downscale) << 1); }
+    };
+
+    /// Cached image.
+    struct Entry
+    {
+        CachedImage img;
+        uint64_t size;
+        std::list<Key>::iterator lruIt;
+    };
+
+    /**
+     * @brief Insert a loaded image, evicting images to stay within budget.
+     * @note must be called with the cache mutex locked
+     */
+    void insert(const Key& key, const CachedImage& img);
+
+    /**
+     * @brief Remove an image from cache.
+     * @note must be called with the cache mutex locked
+     */
+    void evict(const Key& key);
+
+    /**
+     * @brief Set the memory budget, evicting images if needed and notifying clients if it has changed.
+     * @param[in] capacity memory budget, in bytes
+     * @param[in] capacityRatio memory budget as a proportion of available RAM
+     */
+    void updateCapacity(uint64_t capacity, double capacityRatio);
+
+    /**
+     * @brief Evict images until the memory used plus the given amount fits in the budget.
+     * @note must be called with the cache mutex locked
+     */
+    void shrink(uint64_t toFit);
+
+    /**
+     * @brief Choose the images to evict according to the eviction policy, so that the given amount fits in the budget.
+     * @note must be called with the cache mutex locked, advisors are queried at most once per image
+     * @return images to evict, in eviction order
+     */
+    std::vector<Key> selectVictims(uint64_t toFit) const;
+
+    /// Memory budget, in bytes.
+    uint64_t _capacity;
+
+    /// Memory budget as a proportion of available RAM when it was set.
+    double _capacityRatio;
+
+    /// Memory used by cached images, in bytes.
+    uint64_t _memoryUsage = 0;
+
+    /// Storage precision of newly decoded images.
+    EStorageMode _storageMode = EStorageMode::Float;
+
+    /// Use the persistent proxy store for downscaled images.
+    bool _persistent = false;
+
+    /// Eviction strategy.
+    EEvictionPolicy _evictionPolicy = EEvictionPolicy::LRU;
+
+    /// Eviction advisors of registered clients.
+    std::vector<EvictionAdvisor*> _advisors;
+
+    /// Cached images.
+    std::unordered_map<Key, Entry, KeyHash> _entries;
+
+    /// Cached images by recency of use (most recently used first).
+    std::list<Key> _lru;
+
+    /// Images currently being loaded, shared with threads requesting them concurrently.
+    std::unordered_map<Key, std::shared_future<CachedImage>, KeyHash> _pending;
+
+    /// Cache mutex.
+    mutable std::mutex _mutex;
+};
+
+}  // namespace imgserve
+}  // namespace qtAliceVision
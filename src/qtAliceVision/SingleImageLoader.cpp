@@ -1,7 +1,12 @@
 #include "SingleImageLoader.hpp"
+#include "IOScheduler.hpp"
+#include "MetadataIndex.hpp"
+#include "ImageDecoder.hpp"
 
-#include <QThreadPool>
+#include <aliceVision/image/resampling.hpp>
 
+
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
 
@@ -15,37 +20,94 @@ SingleImageLoader::SingleImageLoader(QObject* parent)
     _loading = false;
 }
 
-SingleImageLoader::~SingleImageLoader() {}
+SingleImageLoader::~SingleImageLoader()
+{
+    // Stop the active worker thread at its next cancellation point
+    if (_cancel)
+    {
+        *_cancel = true;
+    }
+    IOScheduler::instance().cancel(this);
+}
+
+void SingleImageLoader::setStorageMode(EStorageMode mode)
+{
+    if (mode == _storageMode)
+    {
+        return;
+    }
+    _storageMode = mode;
+    _recent.clear();
+}
 
 ResponseData SingleImageLoader::request(const RequestData& reqData)
 {
     // Check if requested image matches currently loaded image
-    if (reqData.path == _request.path && reqData.downscale == _request.downscale)
+    if (reqData == _request)
     {
         return _response;
     }
 
-    // If there is not already a worker thread
-    // start a new one using the currently requested image
-    if (!_loading)
+    // Check if requested image has been loaded recently
+    const auto it = std::find_if(_recent.begin(), _recent.end(), [&reqData](const auto& entry) { return entry.first == reqData; });
+    if (it != _recent.end())
     {
-        // Update internal state
-        _loading = true;
+        _recent.splice(_recent.begin(), _recent, it);
+        _request = it->first;
+        _response = it->second;
+        return _response;
+    }
 
-        // Create new runnable and launch it in worker thread (managed by Qt thread pool)
-        auto ioRunnable = new SingleImageLoadingIORunnable(reqData);
-        connect(ioRunnable, &SingleImageLoadingIORunnable::done, this, &SingleImageLoader::onSingleImageLoadingDone);
-        QThreadPool::globalInstance()->start(ioRunnable);
+    // Requested image is already being loaded
+    if (_loading && reqData == _loadingRequest)
+    {
+        return ResponseData();
     }
 
+    // Latest request wins: cancel the active worker thread, its result would be outdated
+    if (_cancel)
+    {
+        *_cancel = true;
+    }
+    IOScheduler::instance().cancel(this);
+
+    // Update internal state
+    _loading = true;
+    _loadingRequest = reqData;
+    _cancel = std::make_shared<std::atomic_bool>(false);
+
+    // Create new runnable and launch it in worker thread (managed by the I/O scheduler)
+    // A single load runs at a time: the latest one starts when the superseded one reaches a cancellation point
+    auto ioRunnable = new SingleImageLoadingIORunnable(reqData, _storageMode, _cancel);
+    connect(ioRunnable, &SingleImageLoadingIORunnable::done, this, &SingleImageLoader::onSingleImageLoadingDone);
+    IOScheduler::instance().start(IOScheduler::EIOClass::Interactive, ioRunnable, this, 1);
+
     // Empty response
     return ResponseData();
 }
 
 void SingleImageLoader::onSingleImageLoadingDone(RequestData reqData, ResponseData response)
 {
+    // Keep loaded images, even superseded ones that completed before being cancelled
+    if (response.img || response.halfImg)
+    {
+        _recent.remove_if([&reqData](const auto& entry) { return entry.first == reqData; });
+        _recent.emplace_front(reqData, response);
+        if (_recent.size() > recentCapacity)
+        {
+            _recent.pop_back();
+        }
+    }
+
+    // Ignore results of superseded requests
+    if (!_loading || !(reqData == _loadingRequest))
+    {
+        return;
+    }
+
     // Update internal state
     _loading = false;
+    _cancel.reset();
     _request = reqData;
     _response = response;
 
@@ -53,8 +115,12 @@ void SingleImageLoader::onSingleImageLoadingDone(RequestData reqData, ResponseDa
     Q_EMIT requestHandled();
 }
 
-SingleImageLoadingIORunnable::SingleImageLoadingIORunnable(const RequestData& reqData)
-  : _reqData(reqData)
+SingleImageLoadingIORunnable::SingleImageLoadingIORunnable(const RequestData& reqData,
+                                                           EStorageMode storageMode,
+                                                           const std::shared_ptr<std::atomic_bool>& cancel)
+  : _reqData(reqData),
+    _storageMode(storageMode),
+    _cancel(cancel)
 {}
 
 SingleImageLoadingIORunnable::~SingleImageLoadingIORunnable() {}
@@ -65,27 +131,50 @@ void SingleImageLoadingIORunnable::run()
 
     try
     {
-        // Retrieve metadata from disk
-        int width, height;
-        auto metadata = aliceVision::image::readImageMetadata(_reqData.path, width, height);
+        // Retrieve metadata from the persistent index, or from disk if the file is unknown or was modified
+        // New entries are persisted when the index is destroyed, not on the path of the image being waited for
+        MetadataIndex::instance().read(_reqData.path, response.dim, response.metadata);
 
-        // Store original image dimensions
-        response.dim = QSize(width, height);
+        // Decoding is the longest step, skip it if the request has been superseded meanwhile
+        if (*_cancel)
+        {
+            return;
+        }
 
-        // Copy metadata into a QVariantMap
-        for (const auto& item : metadata)
+        // Increase downscale to fit the maximum size, so that large images are never decoded at full resolution
+        int downscale = _reqData.downscale;
+        const int maxDim = std::max(response.dim.width(), response.dim.height());
+        while (_reqData.maxSize > 0 && maxDim / downscale > _reqData.maxSize)
         {
-            response.metadata[QString::fromStdString(item.name().string())] = QString::fromStdString(item.get_string());
+            downscale *= 2;
         }
 
-        // Load image
+        // Load image, directly at the downscaled resolution when the file allows it
+        // Decoding stops between scanlines if the request is superseded, the incomplete image is discarded
         response.img = std::make_shared<aliceVision::image::Image<aliceVision::image::RGBAfColor>>();
-        aliceVision::image::readImage(_reqData.path, *(response.img), aliceVision::image::EImageColorSpace::LINEAR);
+        response.bytesCopied = decodeImage(_reqData.path, downscale, *(response.img), _cancel.get());
+
+        if (*_cancel)
+        {
+            return;
+        }
+
+        // Halve the image if it still exceeds the maximum size (e.g. dimensions were unknown)
+        while (_reqData.maxSize > 0 && (response.img->Width() > _reqData.maxSize || response.img->Height() > _reqData.maxSize))
+        {
+            auto halved = std::make_shared<aliceVision::image::Image<aliceVision::image::RGBAfColor>>();
+            aliceVision::image::ImageHalfSample(*(response.img), *halved);
+            response.img = halved;
+            const uint64_t nbPixels = static_cast<uint64_t>(halved->Width()) * static_cast<uint64_t>(halved->Height());
+            response.bytesCopied += nbPixels * sizeof(aliceVision::image::RGBAfColor);
+        }
 
-        // Apply downscale
-        if (_reqData.downscale > 1)
+        // Convert to storage precision, releasing the full precision image
+        if (_storageMode == EStorageMode::Half)
         {
-            aliceVision::imageAlgo::resizeImage(_reqData.downscale, *(response.img));
+            response.halfImg = std::make_shared<HalfImage>(*(response.img));
+            response.img.reset();
+            response.bytesCopied += response.halfImg->memorySize();
         }
     }
     catch (const std::runtime_error& e)
@@ -1,18 +1,27 @@
 #pragma once
 
 #include "ImageServer.hpp"
+#include "SharedImageCache.hpp"
 
 #include <QObject>
 #include <QRunnable>
 #include <QString>
 
+#include <atomic>
+#include <list>
+#include <memory>
 #include <string>
+#include <utility>
 
 namespace qtAliceVision {
 namespace imgserve {
 
 /**
  * @brief Image server that can load a single image at a time.
+ *
+ * Requests follow a latest-wins policy: a new request supersedes the one being loaded,
+ * which is cancelled as soon as its worker reaches a cancellation point.
+ * The most recently loaded images are kept, so that going back to one of them does not decode it again.
  */
 class SingleImageLoader : public QObject, public ImageServer
 {
@@ -29,9 +38,19 @@ class SingleImageLoader : public QObject, public ImageServer
     // Request management
 
     /// If the image requested cannot be retrieved immediatly,
-    /// this method will launch a worker thread to load it from disk.
+    /// this method will launch a worker thread to load it from disk, cancelling the load of a previous request.
     ResponseData request(const RequestData& reqData) override;
 
+    /**
+     * @brief Set the precision used to store loaded images.
+     * @note takes effect from the next loaded image, recently loaded images are released
+     * @param[in] mode storage mode
+     */
+    void setStorageMode(EStorageMode mode);
+
+    /// Get the precision used to store loaded images.
+    EStorageMode getStorageMode() const { return _storageMode; }
+
     /**
      * @brief Slot called when the loading thread is done.
      * @param[in] reqData request data used to create the loading thread
@@ -47,6 +66,9 @@ class SingleImageLoader : public QObject, public ImageServer
   private:
     // Member variables
 
+    /// Number of recently loaded images kept in memory, including the latest one.
+    static constexpr std::size_t recentCapacity = 4;
+
     /// Latest request data.
     RequestData _request;
 
@@ -55,6 +77,18 @@ class SingleImageLoader : public QObject, public ImageServer
 
     /// Keep track of whether or not there is an active worker thread.
     bool _loading;
+
+    /// Request being loaded by the active worker thread.
+    RequestData _loadingRequest;
+
+    /// Cancellation flag of the active worker thread.
+    std::shared_ptr<std::atomic_bool> _cancel;
+
+    /// Recently loaded images, from the most recently used.
+    std::list<std::pair<RequestData, ResponseData>> _recent;
+
+    /// Precision used to store loaded images.
+    EStorageMode _storageMode = EStorageMode::Float;
 };
 
 /**
@@ -66,9 +100,11 @@ class SingleImageLoadingIORunnable : public QObject, public QRunnable
 
   public:
     /**
-     * @param[in] path filepath of the image to load
+     * @param[in] reqData request data of the image to load
+     * @param[in] storageMode precision used to store the loaded image
+     * @param[in] cancel flag set by the main thread when the request has been superseded
      */
-    explicit SingleImageLoadingIORunnable(const RequestData& reqData);
+    SingleImageLoadingIORunnable(const RequestData& reqData, EStorageMode storageMode, const std::shared_ptr<std::atomic_bool>& cancel);
 
     ~SingleImageLoadingIORunnable();
 
@@ -76,7 +112,7 @@ class SingleImageLoadingIORunnable : public QObject, public QRunnable
     Q_SLOT void run() override;
 
     /**
-     * @brief Signal emitted when image loading is finished.
+     * @brief Signal emitted when image loading is finished (not emitted if loading has been cancelled).
      * @param[in] reqData request data used to create the loading thread
      * @param[in] response a ResponseData instance containing the data loaded from disk
      */
@@ -85,6 +121,12 @@ class SingleImageLoadingIORunnable : public QObject, public QRunnable
   private:
     /// Request data of image to load.
     RequestData _reqData;
+
+    /// Precision used to store the loaded image.
+    EStorageMode _storageMode;
+
+    /// Cancellation flag, checked between loading steps.
+    std::shared_ptr<std::atomic_bool> _cancel;
 };
 
 }  // namespace imgserve
@@ -0,0 +1,128 @@
+#include "TexturePool.hpp"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+
+#include <map>
+#include <memory>
+
+namespace qtAliceVision {
+
+namespace {
+
+/// Memory used by a texture, stored as half float RGBA whatever the uploaded pixel type.
+uint64_t textureMemorySize(const QSize& size) { return static_cast<uint64_t>(size.width()) * static_cast<uint64_t>(size.height()) * 8; }
+
+/// Pools of all OpenGL contexts (each render thread has its own context).
+std::map<QOpenGLContext*, std::unique_ptr<TexturePool>>& pools()
+{
+    static std::map<QOpenGLContext*, std::unique_ptr<TexturePool>> contextPools;
+    return contextPools;
+}
+
+QMutex poolsMutex;
+
+}  // namespace
+
+TexturePool& TexturePool::forContext(QOpenGLContext* context)
+{
+    QMutexLocker lock(&poolsMutex);
+
+    auto it = pools().find(context);
+    if (it == pools().end())
+    {
+        it = pools().emplace(context, std::unique_ptr<TexturePool>(new TexturePool(context))).first;
+
+        // Textures are deleted while the context is still current
+        QObject::connect(
+          context,
+          &QOpenGLContext::aboutToBeDestroyed,
+          context,
+          [context]() {
+              QMutexLocker destroyLock(&poolsMutex);
+              pools().erase(context);
+          },
+          Qt::DirectConnection);
+    }
+    return *(it->second);
+}
+
+TexturePool::TexturePool(QOpenGLContext* context)
+  : _context(context)
+{}
+
+TexturePool::~TexturePool()
+{
+    if (QOpenGLContext::currentContext() != _context)
+    {
+        return;
+    }
+    deleteOrphans();
+    for (Entry& entry : _entries)
+    {
+        _context->functions()->glDeleteTextures(1, &entry.textureId);
+    }
+}
+
+unsigned int TexturePool::acquire(const QSize& size, unsigned int type)
+{
+    deleteOrphans();
+    for (auto it = _entries.begin(); it != _entries.end(); ++it)
+    {
+        if (it->size == size && it->type == type)
+        {
+            const unsigned int textureId = it->textureId;
+            _size -= textureMemorySize(it->size);
+            _entries.erase(it);
+            return textureId;
+        }
+    }
+    return 0;
+}
+
+void TexturePool::release(unsigned int textureId, const QSize& size, unsigned int type)
+{
+    deleteOrphans();
+    _entries.push_front({textureId, size, type});
+    _size += textureMemorySize(size);
+
+    while (_size > capacity && !_entries.empty())
+    {
+        Entry& entry = _entries.back();
+        _context->functions()->glDeleteTextures(1, &entry.textureId);
+        _size -= textureMemorySize(entry.size);
+        _entries.pop_back();
+    }
+}
+
+void TexturePool::deleteLater(unsigned int textureId, unsigned int pixelBuffer)
+{
+    QMutexLocker lock(&_orphansMutex);
+    if (textureId)
+    {
+        _orphanTextures.push_back(textureId);
+    }
+    if (pixelBuffer)
+    {
+        _orphanBuffers.push_back(pixelBuffer);
+    }
+}
+
+void TexturePool::deleteOrphans()
+{
+    QMutexLocker lock(&_orphansMutex);
+    if (!_orphanTextures.empty())
+    {
+        _context->functions()->glDeleteTextures(static_cast<int>(_orphanTextures.size()), _orphanTextures.data());
+        _orphanTextures.clear();
+    }
+    if (!_orphanBuffers.empty())
+    {
+        _context->functions()->glDeleteBuffers(static_cast<int>(_orphanBuffers.size()), _orphanBuffers.data());
+        _orphanBuffers.clear();
+    }
+}
+
+}  // namespace qtAliceVision
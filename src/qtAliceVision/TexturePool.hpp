@@ -0,0 +1,91 @@
+#pragma once
+
+#include <QMutex>
+#include <QSize>
+
+#include <cstdint>
+#include <list>
+#include <vector>
+
+class QOpenGLContext;
+
+namespace qtAliceVision {
+
+/**
+ * @brief Pool of OpenGL textures with allocated storage, keyed by dimensions and pixel type.
+ *
+ * Textures whose image changes dimensions or format, or that are destroyed, give their storage back to the pool
+ * instead of deleting it: textures of the same dimensions and format then reuse it without any GL allocation.
+ * Each OpenGL context has its own pool, destroyed with the context. Pools must only be used from the render thread,
+ * except for deleteLater.
+ */
+class TexturePool
+{
+  public:
+    /// Maximum memory used by pooled textures, in bytes.
+    static constexpr uint64_t capacity = 256ull * 1024 * 1024;
+
+    /**
+     * @brief Get the pool of an OpenGL context, created on first use.
+     * @param[in] context OpenGL context
+     */
+    static TexturePool& forContext(QOpenGLContext* context);
+
+    ~TexturePool();
+
+    TexturePool(const TexturePool&) = delete;
+    TexturePool& operator=(const TexturePool&) = delete;
+
+    /**
+     * @brief Take a texture out of the pool.
+     * @param[in] size texture dimensions
+     * @param[in] type GL type of pixel components uploaded to the texture
+     * @return the id of a texture with allocated storage, or 0 if the pool has none of these dimensions and format
+     */
+    unsigned int acquire(const QSize& size, unsigned int type);
+
+    /**
+     * @brief Give a texture back to the pool, deleting least recently released textures to fit the capacity.
+     * @param[in] textureId texture id
+     * @param[in] size dimensions of the texture storage
+     * @param[in] type GL type of pixel components uploaded to the texture
+     */
+    void release(unsigned int textureId, const QSize& size, unsigned int type);
+
+    /**
+     * @brief Delete a texture and a pixel buffer at the next use of the pool, or when the context is destroyed.
+     * @note can be called from any thread, e.g. by a texture destroyed while the context is not current
+     * @param[in] textureId texture id (may be 0)
+     * @param[in] pixelBuffer pixel buffer id, unmapped by its deletion if mapped (may be 0)
+     */
+    void deleteLater(unsigned int textureId, unsigned int pixelBuffer);
+
+  private:
+    explicit TexturePool(QOpenGLContext* context);
+
+    /// Delete GL objects passed to deleteLater, the context being current.
+    void deleteOrphans();
+
+    struct Entry
+    {
+        unsigned int textureId;
+        QSize size;
+        unsigned int type;
+    };
+
+    /// Context owning pooled textures.
+    QOpenGLContext* _context;
+
+    /// Pooled textures, most recently released first.
+    std::list<Entry> _entries;
+
+    /// Memory used by pooled textures, in bytes.
+    uint64_t _size = 0;
+
+    /// GL objects to delete from the render thread.
+    QMutex _orphansMutex;
+    std::vector<unsigned int> _orphanTextures;
+    std::vector<unsigned int> _orphanBuffers;
+};
+
+}  // namespace qtAliceVision
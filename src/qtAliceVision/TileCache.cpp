@@ -0,0 +1,226 @@
+#include "TileCache.hpp"
+#include "IOScheduler.hpp"
+#include "ImageDecoder.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+namespace qtAliceVision {
+namespace imgserve {
+
+namespace {
+
+/// Memory used by the pixels of a tile, in bytes.
+uint64_t tileMemorySize(const TileStore::Tile& tile)
+{
+    return static_cast<uint64_t>(tile->Width()) * static_cast<uint64_t>(tile->Height()) * sizeof(aliceVision::image::RGBAfColor);
+}
+
+}  // namespace
+
+void TileStore::insert(const TileKey& key, const Tile& tile)
+{
+    if (tiles.find(key) != tiles.end())
+    {
+        return;
+    }
+
+    lru.push_front(key);
+    tiles[key] = std::make_pair(tile, lru.begin());
+    size += tileMemorySize(tile);
+
+    evict();
+}
+
+void TileStore::evict()
+{
+    // The most recently used tile is always kept
+    while (size > capacity && lru.size() > 1)
+    {
+        const auto it = tiles.find(lru.back());
+        size -= tileMemorySize(it->second.first);
+        tiles.erase(it);
+        lru.pop_back();
+    }
+}
+
+TileCache::TileCache(QObject* parent)
+  : QObject(parent),
+    _store(std::make_shared<TileStore>())
+{}
+
+TileCache::~TileCache()
+{
+    // Drop queued tiles, running workers only hold a reference to the tile store
+    IOScheduler::instance().cancel(this);
+}
+
+void TileCache::setSource(const std::string& path)
+{
+    // Drop queued tiles of the previous source
+    IOScheduler::instance().cancel(this);
+
+    {
+        std::lock_guard<std::mutex> lock(_store->mutex);
+        if (path == _store->path)
+        {
+            return;
+        }
+    }
+
+    // Only the header is read, files read entirely for each tile are not tiled
+    const bool tileable = !path.empty() && canDecodeRegion(path);
+
+    std::lock_guard<std::mutex> lock(_store->mutex);
+    _store->path = path;
+    _store->tileable = tileable;
+    _store->generation++;
+    _store->tiles.clear();
+    _store->lru.clear();
+    _store->size = 0;
+
+    // Tiles of the previous source still being loaded must not hide the same keys of the new source
+    _store->loading.clear();
+}
+
+bool TileCache::isTileable() const
+{
+    std::lock_guard<std::mutex> lock(_store->mutex);
+    return _store->tileable;
+}
+
+uint64_t TileCache::getCapacity() const
+{
+    std::lock_guard<std::mutex> lock(_store->mutex);
+    return _store->capacity;
+}
+
+void TileCache::setCapacity(uint64_t capacity)
+{
+    std::lock_guard<std::mutex> lock(_store->mutex);
+    _store->capacity = capacity;
+    _store->evict();
+}
+
+std::vector<TileStore::Tile> TileCache::request(const std::vector<TileKey>& keys)
+{
+    // Drop tiles queued for previous requests, they may be out of the viewport now
+    IOScheduler::instance().cancel(this);
+
+    std::vector<TileStore::Tile> tiles(keys.size());
+    std::vector<TileKey> missing;
+    int generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(_store->mutex);
+        generation = _store->generation;
+        if (_store->path.empty() || !_store->tileable)
+        {
+            return tiles;
+        }
+
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            const auto it = _store->tiles.find(keys[i]);
+            if (it != _store->tiles.end())
+            {
+                // Mark tile as recently used
+                _store->lru.splice(_store->lru.begin(), _store->lru, it->second.second);
+                tiles[i] = it->second.first;
+            }
+            else if (_store->loading.find(keys[i]) == _store->loading.end())
+            {
+                missing.push_back(keys[i]);
+            }
+        }
+    }
+
+    // Queue missing tiles by decreasing priority
+    for (const TileKey& key : missing)
+    {
+        auto ioRunnable = new TileIORunnable(_store, generation, key);
+        connect(ioRunnable, &TileIORunnable::loaded, this, &TileCache::onTileLoaded);
+        IOScheduler::instance().start(IOScheduler::EIOClass::Interactive, ioRunnable, this);
+    }
+
+    return tiles;
+}
+
+void TileCache::onTileLoaded(int generation)
+{
+    {
+        std::lock_guard<std::mutex> lock(_store->mutex);
+        if (generation != _store->generation)
+        {
+            return;
+        }
+    }
+
+    // Notify listeners that a tile is available
+    Q_EMIT tileLoaded();
+}
+
+TileIORunnable::TileIORunnable(const std::shared_ptr<TileStore>& store, int generation, const TileKey& key)
+  : _store(store),
+    _generation(generation),
+    _key(key)
+{}
+
+TileIORunnable::~TileIORunnable() {}
+
+void TileIORunnable::run()
+{
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(_store->mutex);
+
+        // Tile is outdated, already loaded or being loaded by another thread
+        if (_generation != _store->generation || _store->tiles.find(_key) != _store->tiles.end() ||
+            !_store->loading.insert(_key).second)
+        {
+            return;
+        }
+        path = _store->path;
+    }
+
+    // Read the tile region at the resolution of its level
+    auto tile = std::make_shared<aliceVision::image::Image<aliceVision::image::RGBAfColor>>();
+    bool success = false;
+    try
+    {
+        Region region;
+        region.x = _key.x * TileCache::tileSize;
+        region.y = _key.y * TileCache::tileSize;
+        region.width = TileCache::tileSize;
+        region.height = TileCache::tileSize;
+        decodeRegion(path, 1 << _key.level, region, *tile);
+        success = tile->Width() > 0 && tile->Height() > 0;
+    }
+    catch (const std::runtime_error& e)
+    {
+        // Log error message
+        std::cerr << e.what() << std::endl;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_store->mutex);
+        if (_generation != _store->generation)
+        {
+            // Loading keys have been reset with the source, the key may be loaded for the new source
+            return;
+        }
+        _store->loading.erase(_key);
+        if (!success)
+        {
+            return;
+        }
+        _store->insert(_key, tile);
+    }
+
+    // Notify listeners that the tile is available
+    Q_EMIT loaded(_generation);
+}
+
+}  // namespace imgserve
+}  // namespace qtAliceVision
+
+#include "TileCache.moc"
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <aliceVision/image/all.hpp>
+
+#include <QObject>
+#include <QRunnable>
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace qtAliceVision {
+namespace imgserve {
+
+/**
+ * @brief Identifier of a tile of an image, at a given MIP level.
+ */
+struct TileKey
+{
+    /// MIP level (0 for full resolution, each level halves image dimensions).
+    int level = 0;
+
+    /// Column and row of the tile in the level.
+    int x = 0;
+    int y = 0;
+
+    bool operator<(const TileKey& other) const
+    {
+        if (level != other.level)
+            return level < other.level;
+        if (y != other.y)
+            return y < other.y;
+        return x < other.x;
+    }
+
+    bool operator==(const TileKey& other) const { return level == other.level && x == other.x && y == other.y; }
+};
+
+/**
+ * @brief Tiles shared between a tile cache and its worker threads.
+ */
+struct TileStore
+{
+    using Tile = std::shared_ptr<aliceVision::image::Image<aliceVision::image::RGBAfColor>>;
+
+    /// Insert a tile, evicting least recently used tiles to fit the capacity.
+    /// @note must be called with the store mutex locked
+    void insert(const TileKey& key, const Tile& tile);
+
+    /// Evict least recently used tiles until the store fits its capacity.
+    /// @note must be called with the store mutex locked
+    void evict();
+
+    std::mutex mutex;
+
+    /// Source image filepath.
+    std::string path;
+
+    /// Whether tiles of the source can be read without reading the whole image.
+    bool tileable = false;
+
+    /// Incremented when the source changes, to discard tiles of previous sources.
+    int generation = 0;
+
+    /// Loaded tiles, with their position in the LRU list.
+    std::map<TileKey, std::pair<Tile, std::list<TileKey>::iterator>> tiles;
+
+    /// Tile keys, most recently used first.
+    std::list<TileKey> lru;
+
+    /// Tiles of the current source being loaded by worker threads.
+    std::set<TileKey> loading;
+
+    /// Memory used by loaded tiles, in bytes.
+    uint64_t size = 0;
+
+    /// Maximum memory used by loaded tiles, in bytes.
+    uint64_t capacity = 256ull * 1024 * 1024;
+};
+
+/**
+ * @brief Cache of fixed-size tiles of a single image, loaded asynchronously at any MIP level.
+ *
+ * Viewers request the tiles intersecting their viewport at the level matching their zoom:
+ * memory usage and loading cost scale with screen pixels, not image pixels.
+ * Tiles queued for a previous request and not requested anymore are dropped before being loaded.
+ * Loaded tiles are kept up to a memory budget, least recently used tiles are evicted first.
+ */
+class TileCache : public QObject
+{
+    Q_OBJECT
+
+  public:
+    /// Width and height of tiles, in pixels.
+    static constexpr int tileSize = 512;
+
+    explicit TileCache(QObject* parent = nullptr);
+
+    ~TileCache() override;
+
+    /**
+     * @brief Set the image to tile, discarding tiles of the previous image.
+     * @param[in] path image filepath
+     */
+    void setSource(const std::string& path);
+
+    /**
+     * @brief Check if the source can be tiled, i.e. if its tiles can be read without reading the whole image.
+     * @note requests return no tiles for other sources, which should be displayed entirely
+     */
+    bool isTileable() const;
+
+    /// Get the maximum memory used by loaded tiles, in bytes.
+    uint64_t getCapacity() const;
+
+    /**
+     * @brief Set the maximum memory used by loaded tiles, evicting tiles if needed.
+     * @param[in] capacity maximum memory, in bytes
+     */
+    void setCapacity(uint64_t capacity);
+
+    /**
+     * @brief Request tiles, loading the missing ones in worker threads.
+     * @note tiles are loaded in the order of the request, tiles still queued from previous requests are dropped
+     * @param[in] keys tiles to request, by decreasing priority
+     * @return requested tiles in the same order, null for tiles that are not loaded yet
+     */
+    std::vector<TileStore::Tile> request(const std::vector<TileKey>& keys);
+
+    /**
+     * @brief Slot called when a worker thread has loaded a tile.
+     * @param[in] generation source generation of the tile
+     */
+    Q_SLOT void onTileLoaded(int generation);
+
+    /**
+     * @brief Signal emitted when a tile of the current source has been loaded.
+     */
+    Q_SIGNAL void tileLoaded();
+
+  private:
+    /// Tiles shared with worker threads.
+    std::shared_ptr<TileStore> _store;
+};
+
+/**
+ * @brief Utility class for loading a tile asynchronously.
+ */
+class TileIORunnable : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+  public:
+    /**
+     * @param[in] store tile store to fill
+     * @param[in] generation source generation when the tile was requested
+     * @param[in] key tile to load
+     */
+    TileIORunnable(const std::shared_ptr<TileStore>& store, int generation, const TileKey& key);
+
+    ~TileIORunnable() override;
+
+    /// Main method for loading a tile in a worker thread.
+    Q_SLOT void run() override;
+
+    /**
+     * @brief Signal emitted when the tile has been loaded and inserted in the store.
+     * @param[in] generation source generation of the tile
+     */
+    Q_SIGNAL void loaded(int generation);
+
+  private:
+    std::shared_ptr<TileStore> _store;
+    int _generation;
+    TileKey _key;
+};
+
+}  // namespace imgserve
+}  // namespace qtAliceVision
@@ -0,0 +1,407 @@
+#include "SequenceCache.hpp"
+#include "SingleImageLoader.hpp"
+
+#include <aliceVision/image/all.hpp>
+
+#include <OpenImageIO/imageio.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+    #define NOMINMAX
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+// Headless benchmark of the imgserve subsystem.
+//
+// Synthetic sequences are written to a temporary folder, then image servers are driven through ImageServer::request
+// with the access patterns of the viewer: first display, playback, scrubbing and browsing single images.
+// Each scenario starts with a cold image cache.
+
+using namespace qtAliceVision::imgserve;
+
+namespace {
+
+struct Options
+{
+    int nbFrames = 100;
+    int width = 1280;
+    int height = 720;
+    double fps = 24.0;
+    bool half = false;
+    QStringList formats = {"exr", "png"};
+    int timeout = 120000;
+};
+
+/// Peak resident memory of the process, in bytes.
+uint64_t peakRss()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return static_cast<uint64_t>(counters.PeakWorkingSetSize);
+    }
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    #if defined(__APPLE__)
+    return static_cast<uint64_t>(usage.ru_maxrss);
+    #else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+    #endif
+#endif
+}
+
+double toMiB(uint64_t bytes) { return static_cast<double>(bytes) / (1024. * 1024.); }
+
+/// Print a result line.
+void report(const std::string& scenario, const std::string& metric, double value, const std::string& unit)
+{
+    std::printf("%-24s %-32s %12.2f %s\n", scenario.c_str(), metric.c_str(), value, unit.c_str());
+    std::fflush(stdout);
+}
+
+/**
+ * @brief Write a synthetic frame: a gradient moving with the frame number, with per-pixel noise so that files do not compress trivially.
+ */
+void writeFrame(const std::string& path, const Options& options, int frame, oiio::TypeDesc format)
+{
+    const std::size_t width = static_cast<std::size_t>(options.width);
+    const std::size_t height = static_cast<std::size_t>(options.height);
+    std::vector<float> pixels(width * height * 4);
+
+    std::minstd_rand noise(static_cast<unsigned>(frame) + 1);
+    std::uniform_real_distribution<float> noiseValue(0.f, 0.05f);
+    const float shift = static_cast<float>(frame) / static_cast<float>(options.nbFrames);
+    for (std::size_t y = 0; y < height; ++y)
+    {
+        for (std::size_t x = 0; x < width; ++x)
+        {
+            float* pixel = &pixels[(y * width + x) * 4];
+            const float u = static_cast<float>(x) / static_cast<float>(width) + shift;
+            pixel[0] = u - static_cast<float>(static_cast<int>(u)) + noiseValue(noise);
+            pixel[1] = static_cast<float>(y) / static_cast<float>(height) + noiseValue(noise);
+            pixel[2] = 0.5f + noiseValue(noise);
+            pixel[3] = 1.f;
+        }
+    }
+
+    std::unique_ptr<oiio::ImageOutput> output = oiio::ImageOutput::create(path);
+    const oiio::ImageSpec spec(options.width, options.height, 4, format);
+    if (!output || !output->open(path, spec) || !output->write_image(oiio::TypeDesc::FLOAT, pixels.data()) || !output->close())
+    {
+        throw std::runtime_error("Failed to write synthetic frame: " + path);
+    }
+}
+
+/// Write a synthetic sequence in a folder, returning its filepaths in sequence order.
+QVariantList synthesizeSequence(const QString& folder, const QString& format, const Options& options)
+{
+    const oiio::TypeDesc pixelType = (format == "exr") ? oiio::TypeDesc::HALF : oiio::TypeDesc::UINT8;
+
+    QVariantList paths;
+    for (int frame = 0; frame < options.nbFrames; ++frame)
+    {
+        const QString path = QDir(folder).filePath(QString("frame_%1.%2").arg(frame, 5, 10, QChar('0')).arg(format));
+        writeFrame(path.toStdString(), options, frame, pixelType);
+        paths.append(path);
+    }
+    return paths;
+}
+
+/// Deliver signals of worker threads for a given time.
+void processEventsFor(int ms)
+{
+    QElapsedTimer timer;
+    timer.start();
+    do
+    {
+        QCoreApplication::processEvents();
+        QThread::msleep(1);
+    } while (timer.elapsed() < ms);
+}
+
+/// Check if a response holds the requested image (not a proxy).
+bool isHit(const ResponseData& response) { return (response.img || response.halfImg) && !response.proxy; }
+
+RequestData makeRequest(const QVariantList& paths, int frame)
+{
+    RequestData reqData;
+    reqData.path = paths[frame].toString().toStdString();
+    return reqData;
+}
+
+/// Create a sequence cache configured for the benchmark, the image cache is cold if no other instance exists.
+std::unique_ptr<SequenceCache> makeSequenceCache(const Options& options)
+{
+    auto cache = std::make_unique<SequenceCache>();
+    cache->setPersistentCache(false);
+    cache->setStorageMode(options.half ? EStorageMode::Half : EStorageMode::Float);
+    cache->setTargetSize(std::max(options.width, options.height));
+    return cache;
+}
+
+/// Request a frame until it is available, returning the time taken in milliseconds (negative on timeout).
+double waitForFrame(ImageServer& server, const RequestData& reqData, int timeout)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < timeout)
+    {
+        if (isHit(server.request(reqData)))
+        {
+            return static_cast<double>(timer.nsecsElapsed()) * 1e-6;
+        }
+        processEventsFor(1);
+    }
+    return -1.0;
+}
+
+int countCachedFrames(const SequenceCache& cache)
+{
+    int nbCached = 0;
+    for (int frame = 0; frame < cache.getNbFrames(); ++frame)
+    {
+        nbCached += cache.isCached(frame) ? 1 : 0;
+    }
+    return nbCached;
+}
+
+/// Time to first frame of a new sequence, then prefetching throughput until the whole sequence is cached.
+void benchmarkPrefetching(const std::string& name, const QVariantList& paths, const Options& options)
+{
+    auto cache = makeSequenceCache(options);
+
+    QElapsedTimer timer;
+    timer.start();
+    cache->setSequence(paths);
+    const double firstFrame = waitForFrame(*cache, makeRequest(paths, 0), options.timeout);
+    report(name, "time to first frame", firstFrame, "ms");
+
+    // Prefetching goes on without requests, until the sequence is cached or progress stalls
+    const int64_t tFirst = timer.elapsed();
+    int64_t tProgress = tFirst;
+    int nbCached = countCachedFrames(*cache);
+    while (nbCached < options.nbFrames && timer.elapsed() - tProgress < 5000 && timer.elapsed() < options.timeout)
+    {
+        processEventsFor(10);
+        const int nbNow = countCachedFrames(*cache);
+        if (nbNow != nbCached)
+        {
+            nbCached = nbNow;
+            tProgress = timer.elapsed();
+        }
+    }
+
+    const double seconds = static_cast<double>(std::max<int64_t>(1, tProgress - tFirst)) * 1e-3;
+    const uint64_t frameBytes = static_cast<uint64_t>(options.width) * static_cast<uint64_t>(options.height) * (options.half ? 8u : 16u);
+    const double nbPrefetched = static_cast<double>(std::max(0, nbCached - 1));
+    report(name, "prefetched frames", nbPrefetched, "frames");
+    report(name, "prefetch throughput", nbPrefetched / seconds, "frames/s");
+    report(name, "prefetch throughput", nbPrefetched * toMiB(frameBytes) / seconds, "MiB/s");
+    report(name, "decode latency p50", cache->getDecodeLatency(50.0), "ms");
+    report(name, "decode latency p99", cache->getDecodeLatency(99.0), "ms");
+}
+
+/// Playback at the target frame rate from a cold cache, frames not in cache when due are dropped.
+void benchmarkPlayback(const std::string& name, const QVariantList& paths, const Options& options)
+{
+    auto cache = makeSequenceCache(options);
+    cache->setInteractivePrefetching(false);
+    cache->setPrefetchPolicy(std::make_unique<DirectionalPrefetchPolicy>());
+    cache->setSequence(paths);
+    waitForFrame(*cache, makeRequest(paths, 0), options.timeout);
+
+    // The first quarter of the sequence is a warm-up, the rest measures the steady state
+    const int warmup = options.nbFrames / 4;
+    int nbHits = 0;
+    int nbSteadyHits = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for (int frame = 0; frame < options.nbFrames; ++frame)
+    {
+        const bool hit = isHit(cache->request(makeRequest(paths, frame)));
+        nbHits += hit ? 1 : 0;
+        nbSteadyHits += (hit && frame >= warmup) ? 1 : 0;
+
+        // Wait for the next frame time, derived from the start to avoid drift
+        const int64_t due = static_cast<int64_t>(static_cast<double>(frame + 1) * 1000.0 / options.fps);
+        processEventsFor(static_cast<int>(std::max<int64_t>(0, due - timer.elapsed())));
+    }
+
+    report(name, "playback hit ratio", static_cast<double>(nbHits) / static_cast<double>(options.nbFrames), "");
+    report(name, "steady-state hit ratio", static_cast<double>(nbSteadyHits) / static_cast<double>(std::max(1, options.nbFrames - warmup)), "");
+    report(name, "dropped frames", static_cast<double>(options.nbFrames - nbHits), "frames");
+}
+
+/// Scrubbing back and forth with occasional jumps, at the rate of mouse events.
+void benchmarkScrubbing(const std::string& name, const QVariantList& paths, const Options& options)
+{
+    auto cache = makeSequenceCache(options);
+    cache->setSequence(paths);
+    waitForFrame(*cache, makeRequest(paths, 0), options.timeout);
+
+    std::minstd_rand random(42);
+    std::uniform_int_distribution<int> step(-3, 8);
+    std::uniform_int_distribution<int> jump(0, options.nbFrames - 1);
+    std::uniform_int_distribution<int> percent(0, 99);
+
+    int frame = 0;
+    int nbHits = 0;
+    double requestTime = 0.0;
+    for (int i = 0; i < options.nbFrames; ++i)
+    {
+        frame = (percent(random) < 10) ? jump(random) : std::clamp(frame + step(random), 0, options.nbFrames - 1);
+
+        QElapsedTimer timer;
+        timer.start();
+        nbHits += isHit(cache->request(makeRequest(paths, frame))) ? 1 : 0;
+        requestTime += static_cast<double>(timer.nsecsElapsed()) * 1e-3;
+
+        processEventsFor(33);
+    }
+
+    report(name, "scrub hit ratio", static_cast<double>(nbHits) / static_cast<double>(options.nbFrames), "");
+    report(name, "scrub request time (mean)", requestTime / static_cast<double>(options.nbFrames), "us");
+}
+
+/// Browsing single images one after another, then going back and forth between the last two.
+void benchmarkSingleImages(const std::string& name, const QVariantList& paths, const Options& options)
+{
+    SingleImageLoader loader;
+    loader.setStorageMode(options.half ? EStorageMode::Half : EStorageMode::Float);
+
+    const int nbImages = std::min(20, options.nbFrames);
+    std::vector<double> loadTimes;
+    for (int frame = 0; frame < nbImages; ++frame)
+    {
+        loadTimes.push_back(waitForFrame(loader, makeRequest(paths, frame), options.timeout));
+    }
+    std::sort(loadTimes.begin(), loadTimes.end());
+    report(name, "single image load (median)", loadTimes[loadTimes.size() / 2], "ms");
+
+    int nbHits = 0;
+    const int nbBounces = 10;
+    for (int i = 0; i < nbBounces; ++i)
+    {
+        nbHits += isHit(loader.request(makeRequest(paths, nbImages - 1 - i % 2))) ? 1 : 0;
+    }
+    report(name, "single image bounce hit ratio", static_cast<double>(nbHits) / nbBounces, "");
+}
+
+/// Latency of request dispatch against sequence length, on frames whose metadata is not known yet.
+void benchmarkRequestLatency()
+{
+    // Paths do not exist: silence errors of the metadata scan
+    std::stringstream sink;
+    std::streambuf* cerrBuffer = std::cerr.rdbuf(sink.rdbuf());
+
+    for (const int length : {1000, 10000, 100000})
+    {
+        QVariantList paths;
+        paths.reserve(length);
+        for (int frame = 0; frame < length; ++frame)
+        {
+            paths.append(QString("/nonexistent/benchmark/frame_%1.exr").arg(frame, 6, 10, QChar('0')));
+        }
+
+        SequenceCache cache;
+        cache.setSequence(paths);
+
+        std::minstd_rand random(42);
+        std::uniform_int_distribution<int> frames(0, length - 1);
+        const int nbRequests = 10000;
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < nbRequests; ++i)
+        {
+            cache.request(makeRequest(paths, frames(random)));
+        }
+        report("request dispatch", "length " + std::to_string(length), static_cast<double>(timer.nsecsElapsed()) / nbRequests, "ns/request");
+    }
+
+    std::cerr.rdbuf(cerrBuffer);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("imgserveBenchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless benchmark of qtAliceVision image servers on synthetic sequences.");
+    parser.addHelpOption();
+    QCommandLineOption framesOption("frames", "Number of frames of synthetic sequences.", "count", "100");
+    QCommandLineOption widthOption("width", "Width of synthetic frames.", "pixels", "1280");
+    QCommandLineOption heightOption("height", "Height of synthetic frames.", "pixels", "720");
+    QCommandLineOption fpsOption("fps", "Playback frame rate.", "fps", "24");
+    QCommandLineOption formatsOption("formats", "Comma-separated file formats of synthetic sequences (exr, png).", "formats", "exr,png");
+    QCommandLineOption halfOption("half", "Store cached images in half float precision.");
+    parser.addOptions({framesOption, widthOption, heightOption, fpsOption, formatsOption, halfOption});
+    parser.process(app);
+
+    Options options;
+    options.nbFrames = std::max(2, parser.value(framesOption).toInt());
+    options.width = std::max(16, parser.value(widthOption).toInt());
+    options.height = std::max(16, parser.value(heightOption).toInt());
+    options.fps = std::max(1.0, parser.value(fpsOption).toDouble());
+    options.formats = parser.value(formatsOption).split(',', Qt::SkipEmptyParts);
+    options.half = parser.isSet(halfOption);
+
+    QTemporaryDir folder;
+    if (!folder.isValid())
+    {
+        std::cerr << "Failed to create a temporary folder" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        for (const QString& format : options.formats)
+        {
+            const std::string name = format.toStdString() + " " + std::to_string(options.width) + "x" + std::to_string(options.height);
+            const QString formatFolder = folder.filePath(format);
+            QDir().mkpath(formatFolder);
+            const QVariantList paths = synthesizeSequence(formatFolder, format, options);
+
+            benchmarkPrefetching(name, paths, options);
+            benchmarkPlayback(name, paths, options);
+            benchmarkScrubbing(name, paths, options);
+            benchmarkSingleImages(name, paths, options);
+            report(name, "peak RSS", toMiB(peakRss()), "MiB");
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    benchmarkRequestLatency();
+    report("process", "peak RSS", toMiB(peakRss()), "MiB");
+
+    return 0;
+}
@@ -3,6 +3,7 @@
 #include "ImageServer.hpp"
 #include "FeaturesViewer.hpp"
 #include "FloatImageViewer.hpp"
+#include "IOScheduler.hpp"
 #include "MFeatures.hpp"
 #include "MSfMDataStats.hpp"
 #include "MTracks.hpp"
@@ -62,6 +63,13 @@ class QtAliceVisionPlugin : public QQmlExtensionPlugin
         qRegisterMetaType<imgserve::RequestData>("imgserve::RequestData");
         qRegisterMetaType<imgserve::ResponseData>("ResponseData");
         qRegisterMetaType<imgserve::ResponseData>("imgserve::ResponseData");
+        qRegisterMetaType<ImageScopes>("ImageScopes");
+
+        // The scheduler is shared by all loaders of the process, QML never owns it
+        qmlRegisterSingletonType<IOScheduler>(uri, 1, 0, "IOScheduler", [](QQmlEngine*, QJSEngine*) -> QObject* {
+            QQmlEngine::setObjectOwnership(&IOScheduler::instance(), QQmlEngine::CppOwnership);
+            return &IOScheduler::instance();
+        });
     }
 };
 